@@ -3,8 +3,19 @@
 
 #include <vector>
 #include <cassert>
+#include <cstddef>
 #include <cstring>
 
+#include "EventArena.h"
+
+//
+// List of pulse numbers passed from selector to selector (see
+// "selectFrom" below). Its buffer is taken from the event arena of
+// the analysis ("eventArena()", see RootChainProcessor.h), so such
+// lists must not be kept beyond the event in which they were made.
+//
+typedef ArenaVector<unsigned> ChannelList;
+
 //
 // Interface class for selecting "good" channels
 //
@@ -24,6 +35,86 @@ struct AbsChannelSelector
     virtual void select(const AnalysisClass& event,
                         std::vector<unsigned char>* mask,
                         std::vector<double>* parentPt) = 0;
+
+    //
+    // Selection among a subset of channels, for use in selector chains
+    // (see ChannelSelectorChain.h). On input, "channels" lists the pulse
+    // numbers still under consideration, in the increasing order. On
+    // output, it must contain the channels kept by this selector, in
+    // the same order. The "parentPt" vector (which is allowed to be
+    // NULL) has "PulseCount" elements. Selectors which associate the
+    // channels with parent objects set the elements for the channels
+    // they keep, other selectors leave it alone.
+    //
+    // The default implementation calls "select" for all channels and
+    // filters the list with the resulting mask (the parentPt values
+    // are discarded). Override it in order to spend time only on the
+    // listed channels. Selectors which make channel lists themselves
+    // (e.g., in their "select") take them from "event.eventArena()".
+    //
+    virtual void selectFrom(const AnalysisClass& event,
+                            ChannelList* channels,
+                            std::vector<double>* /* parentPt */)
+    {
+        assert(channels);
+        select(event, &chainMask_, &chainParentPt_);
+        keepMasked(chainMask_, channels);
+    }
+
+    //
+    // Selectors which keep per-event results other than the channel
+    // list (for example, the FFTJet jets, which are used for histograms
+    // and by other selectors) should return "true". Selector chains then
+    // run them in every event, even when the preceding stages leave no
+    // channels, so that these results never refer to an earlier event.
+    //
+    virtual bool hasEventResults() const {return false;}
+
+    //
+    // Cross-event batching. Before the events of a batch are processed
+    // one by one with "select" or "selectFrom" (in the batch order),
+    // the analysis may pass each of them, in the same order, to
+    // "addToBatch" and then call "submitBatch", so that the selector
+    // can do the expensive part of its work for the whole batch at once
+    // (batched DFFTs, GPU offload, etc). The analysis loads every event
+    // once and gives it to all of its selectors. The selectors must
+    // produce the same results whether or not these methods were called.
+    // The default implementations do nothing.
+    //
+    virtual void addToBatch(const AnalysisClass& /* event */) {}
+    virtual void submitBatch() {}
+
+    //
+    // Heap memory held by the selector for its per-event work, in
+    // bytes (the "SelectorScratch" component of the memory profile,
+    // see MemoryProfile.h). Selectors with their own buffers should
+    // add them to the value returned by the base class.
+    //
+    virtual std::size_t scratchBytes() const
+        {return vectorBytes(chainMask_) + vectorBytes(chainParentPt_);}
+
+protected:
+    template <typename T, class Alloc>
+    static inline std::size_t vectorBytes(const std::vector<T,Alloc>& v)
+        {return v.capacity()*sizeof(T);}
+
+    // Remove the channels with 0 mask values from the list
+    static inline void keepMasked(const std::vector<unsigned char>& mask,
+                                  ChannelList* channels)
+    {
+        const unsigned n = channels->size();
+        unsigned* ch = n ? &(*channels)[0] : 0;
+        unsigned nKept = 0;
+        for (unsigned i=0; i<n; ++i)
+            if (mask[ch[i]])
+                ch[nKept++] = ch[i];
+        channels->resize(nKept);
+    }
+
+private:
+    // Work space for the default "selectFrom"
+    std::vector<unsigned char> chainMask_;
+    std::vector<double> chainParentPt_;
 };
 
 //
@@ -51,6 +142,10 @@ struct AllChannelSelector : public AbsChannelSelector<AnalysisClass>
             memset(&(*pt)[0], 0, event.PulseCount*sizeof(double));
         }
     }
+
+    inline virtual void selectFrom(const AnalysisClass&,
+                                   ChannelList*,
+                                   std::vector<double>*) {}
 };
 
 #endif // AbsChannelSelector_h_
@@ -0,0 +1,44 @@
+#ifndef AbsFFTJetBatchBackend_h_
+#define AbsFFTJetBatchBackend_h_
+
+//
+// Interface for the devices (GPUs) which convolve the FFTJet energy
+// flow grids of many events with the pattern recognition kernel at
+// once. The grids of a batch are submitted together, and the results
+// are collected by a separate call. FFTJetChannelSelector collects them
+// right before processing the first event of the batch, so the CPU
+// waits for the device rather than working at the same time. See
+// FFTJetChannelSelector::setBatchBackend for the use of these results.
+//
+// All grids of a batch are stored contiguously, each one in the
+// Grid2d layout: "nEta()" rows of "nPhi()" numbers.
+//
+
+template <typename Real>
+class AbsFFTJetBatchBackend
+{
+public:
+    inline virtual ~AbsFFTJetBatchBackend() {}
+
+    // Grid dimensions
+    virtual unsigned nEta() const = 0;
+    virtual unsigned nPhi() const = 0;
+
+    // Maximum number of grids in one batch
+    virtual unsigned maxBatch() const = 0;
+
+    // Start the convolutions of "nGrids" grids. The data is copied,
+    // so the buffer can be reused as soon as this method returns.
+    // Only one batch can be in flight: "retrieve" must be called
+    // before the next "submit".
+    virtual void submit(const Real* grids, unsigned nGrids) = 0;
+
+    // Wait for the convolutions of the last submitted batch
+    // and copy the results into the given buffer
+    virtual void retrieve(Real* results) = 0;
+
+    // Short description of the device, for printouts
+    virtual const char* name() const = 0;
+};
+
+#endif // AbsFFTJetBatchBackend_h_
@@ -10,7 +10,10 @@
 // March 2013
 //
 
+#include <memory>
+
 #include "ManagedHisto.h"
+#include "SharedHisto.h"
 #include "TH2D.h"
 
 //
@@ -46,18 +49,31 @@ public:
         // root object ownership conventions
     }
 
-    inline void AutoFill() {histo_->Fill(f1_(), f2_(), w_());}
+    inline void AutoFill()
+    {
+        if (shared_)
+            shared_->fill(f1_(), f2_(), w_());
+        else
+            histo_->Fill(f1_(), f2_(), w_());
+    }
     inline void CycleFill(unsigned) {}
     inline void SetDirectory(TDirectory* d) {histo_->SetDirectory(d);}
     inline const std::string& GetDirectoryName() const {return directory_;}
     inline TH2D* GetRootItem() const {return histo_;}
 
+    inline bool ShareBins(SharedHistoStore& store, const bool owner)
+    {
+        shared_.reset(new SharedHistoFiller(store, histo_, directory_, owner));
+        return true;
+    }
+
 private:
     TH2D* histo_;    
     Functor1 f1_;
     Functor2 f2_;
     Functor3 w_;
     std::string directory_;
+    std::unique_ptr<SharedHistoFiller> shared_;
 };
 
 //
@@ -0,0 +1,107 @@
+#ifndef AutoTree_h_
+#define AutoTree_h_
+
+//
+// Wrapper template for TTree which implements ManagedHisto interface
+// and knows how to fill the tree automatically, once per event. Unlike
+// AutoNtuple, every column becomes a branch whose type is determined
+// by the type returned by the column functor (integer columns remain
+// integers, etc). Use the helper function "AutoTree" to create instances
+// of this class.
+//
+
+#include "ManagedHisto.h"
+#include "TreePacker.h"
+#include "Column.h"
+#include "AllPass.h"
+
+//
+// In the user code, do not create instances of this class directly,
+// call the "AutoTree" function instead
+//
+template <class TreePacker, typename Selector>
+class AutoTreeHelper : public ManagedHisto
+{
+public:
+    AutoTreeHelper(const char* name, const char* title,
+                   const char* directory, const TreePacker& packer,
+                   const Selector& selector)
+        : tree_(0),
+          directory_(directory),
+          packer_(packer),
+          sel_(selector)
+    {
+        tree_ = new TTree(name, title);
+        Cycler::book(tree_, packer_, buffers_, 0);
+    }
+
+    inline virtual ~AutoTreeHelper()
+    {
+        // Do not delete tree_ here due to the idiosyncratic
+        // root object ownership conventions
+    }
+
+    inline void AutoFill()
+    {
+        if (sel_())
+        {
+            Cycler::fill(packer_, buffers_);
+            tree_->Fill();
+        }
+    }
+    inline void CycleFill(unsigned) {}
+    inline void SetDirectory(TDirectory* d) {tree_->SetDirectory(d);}
+    inline const std::string& GetDirectoryName() const {return directory_;}
+    inline TTree* GetRootItem() const {return tree_;}
+
+private:
+    typedef typename tupleutils::TreeBufferTuple<TreePacker,false>::type Buffers;
+    typedef tupleutils::TreeBranchCycler<
+        TreePacker,Buffers,std::tuple_size<TreePacker>::value> Cycler;
+
+    // Branches keep the addresses of the buffers
+    AutoTreeHelper(const AutoTreeHelper&);
+    AutoTreeHelper& operator=(const AutoTreeHelper&);
+
+    TTree* tree_;
+    std::string directory_;
+    TreePacker packer_;
+    Buffers buffers_;
+    Selector sel_;
+};
+
+//
+// TreePacker template parameter is an std::tuple of ColumnHelper objects.
+// Functors inside ColumnHelpers must implement "operator()()" which returns
+// bool, an integer type, float, or double.
+//
+// Selector template parameter is a functor which implements "operator()()"
+// whose result is bool or can be converted to bool. If the result returned
+// by this operator is "true", the tree will be filled.
+//
+// Other arguments have the same meaning as for AutoNtuple.
+//
+template<class TreePacker, class Selector>
+inline AutoTreeHelper<TreePacker, Selector>* AutoTree(
+    const char* name, const char* title,
+    const char* directory, const TreePacker& packer,
+    const Selector& selector)
+{
+    return new AutoTreeHelper<TreePacker, Selector>(
+        name, title, directory, packer, selector);
+}
+
+//
+// Same thing as before but without a selector. Tree will be filled
+// every time.
+//
+template<class TreePacker>
+inline AutoTreeHelper<TreePacker, AllPass>* AutoTree(
+    const char* name, const char* title,
+    const char* directory, const TreePacker& packer)
+{
+    return new AutoTreeHelper<TreePacker, AllPass>(
+        name, title, directory, packer, AllPass());
+}
+
+#endif // AutoTree_h_
@@ -9,6 +9,7 @@
 //
 
 #include <cstring>
+#include <cassert>
 
 struct ChannelChargeInfo
 {
@@ -34,6 +35,27 @@ struct ChannelChargeInfo
         memcpy(Charge, &data.Charge[treeIndex][0], sizeof(Charge));
     }
 
+    //
+    // Similar constructor which takes the charges from the
+    // structure-of-arrays event data (see ChannelDataSoA.h)
+    // instead of the [channel][time slice] tree arrays
+    //
+    template<class TreeData, class SoAData>
+    inline ChannelChargeInfo(const TreeData& data, const SoAData& soa,
+                             const unsigned treeIndex,
+                             const unsigned hbheIndex)
+        : Energy(data.Energy[treeIndex]),
+          RecHitTime(data.RecHitTime[treeIndex]),
+          FlagWord(data.FlagWord[treeIndex]),
+          AuxWord(data.AuxWord[treeIndex]),
+          channelIndex(hbheIndex)
+    {
+        assert(soa.nTimeSlices() == nTimeSlices);
+        assert(treeIndex < soa.size());
+        for (unsigned ts=0; ts<nTimeSlices; ++ts)
+            Charge[ts] = soa.charge(ts)[treeIndex];
+    }
+
     // The meaning of the following members is the same
     // as for the identically named members of NoiseTreeData
     double Charge[nTimeSlices];
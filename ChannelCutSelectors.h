@@ -0,0 +1,167 @@
+#ifndef ChannelCutSelectors_h_
+#define ChannelCutSelectors_h_
+
+//
+// Simple per-channel cuts implementing AbsChannelSelector. They are
+// cheap and are meant to be placed at the front of selector chains
+// (see ChannelSelectorChain.h).
+//
+// EnergyCutChannelSelector keeps the channels with energy above the
+// threshold. The AnalysisClass must provide "PulseCount" and
+// "energies()".
+//
+// PulseTimeChannelSelector keeps the channels whose pulse time,
+// estimated as the charge-weighted mean time slice number (using the
+// pedestal-subtracted charges in the time slices from "minTS" to
+// "maxTS"), is inside the given window. Channels with non-positive
+// charge in the window have no time estimate and are dropped. The
+// AnalysisClass must provide "PulseCount", "channelData()", and
+// "eventArena()" (used for the channel list and the charge sums).
+//
+
+#include <vector>
+#include <cassert>
+#include <stdexcept>
+
+#include "AbsChannelSelector.h"
+#include "ChannelDataSoA.h"
+#include "EventArena.h"
+
+template <class AnalysisClass>
+class EnergyCutChannelSelector : public AbsChannelSelector<AnalysisClass>
+{
+public:
+    inline explicit EnergyCutChannelSelector(const double minEnergy)
+        : minEnergy_(minEnergy) {}
+
+    inline virtual ~EnergyCutChannelSelector() {}
+
+    virtual void select(const AnalysisClass& event,
+                        std::vector<unsigned char>* mask,
+                        std::vector<double>* parentPt)
+    {
+        assert(mask);
+        assert(event.PulseCount >= 0);
+        const unsigned n = event.PulseCount;
+        mask->resize(n);
+        const double* e = event.energies();
+        for (unsigned i=0; i<n; ++i)
+            (*mask)[i] = e[i] > minEnergy_;
+        if (parentPt)
+            parentPt->assign(n, 0.0);
+    }
+
+    virtual void selectFrom(const AnalysisClass& event,
+                            ChannelList* channels,
+                            std::vector<double>*)
+    {
+        assert(channels);
+        const unsigned n = channels->size();
+        if (!n)
+            return;
+        const double* e = event.energies();
+        unsigned* ch = &(*channels)[0];
+        unsigned nKept = 0;
+        for (unsigned i=0; i<n; ++i)
+            if (e[ch[i]] > minEnergy_)
+                ch[nKept++] = ch[i];
+        channels->resize(nKept);
+    }
+
+private:
+    EnergyCutChannelSelector();
+
+    double minEnergy_;
+};
+
+
+template <class AnalysisClass>
+class PulseTimeChannelSelector : public AbsChannelSelector<AnalysisClass>
+{
+public:
+    inline PulseTimeChannelSelector(const unsigned minTS, const unsigned maxTS,
+                                    const double minTime, const double maxTime)
+        : minTS_(minTS), maxTS_(maxTS), minTime_(minTime), maxTime_(maxTime)
+    {
+        if (!(minTS_ < maxTS_))
+            throw std::invalid_argument("In PulseTimeChannelSelector "
+                                        "constructor: invalid time slice range");
+    }
+
+    inline virtual ~PulseTimeChannelSelector() {}
+
+    virtual void select(const AnalysisClass& event,
+                        std::vector<unsigned char>* mask,
+                        std::vector<double>* parentPt)
+    {
+        assert(mask);
+        assert(event.PulseCount >= 0);
+        const unsigned n = event.PulseCount;
+        const ArenaAllocator<unsigned> alloc(event.eventArena());
+        ChannelList channels(n, 0U, alloc);
+        for (unsigned i=0; i<n; ++i)
+            channels[i] = i;
+        selectFrom(event, &channels, 0);
+        mask->assign(n, 0);
+        const unsigned nKept = channels.size();
+        for (unsigned i=0; i<nKept; ++i)
+            (*mask)[channels[i]] = 1;
+        if (parentPt)
+            parentPt->assign(n, 0.0);
+    }
+
+    virtual void selectFrom(const AnalysisClass& event,
+                            ChannelList* channels,
+                            std::vector<double>*)
+    {
+        assert(channels);
+        const unsigned n = channels->size();
+        if (!n)
+            return;
+        unsigned* ch = &(*channels)[0];
+        const ArenaAllocator<double> alloc(event.eventArena());
+        ArenaVector<double> qSum(n, 0.0, alloc);
+        ArenaVector<double> tSum(n, 0.0, alloc);
+        accumulate(event.channelData(), ch, n, &qSum[0], &tSum[0]);
+        unsigned nKept = 0;
+        for (unsigned i=0; i<n; ++i)
+            if (qSum[i] > 0.0)
+            {
+                const double t = tSum[i]/qSum[i];
+                if (t >= minTime_ && t < maxTime_)
+                    ch[nKept++] = ch[i];
+            }
+        channels->resize(nKept);
+    }
+
+private:
+    PulseTimeChannelSelector();
+
+    template <typename PedGainReal>
+    inline void accumulate(const ChannelDataSoA<PedGainReal>& data,
+                           const unsigned* ch, const unsigned n,
+                           double* qs, double* ts)
+    {
+        if (maxTS_ > data.nTimeSlices())
+            throw std::invalid_argument("In PulseTimeChannelSelector::select: "
+                                        "time slice range is too large");
+        for (unsigned its=minTS_; its<maxTS_; ++its)
+        {
+            const double* q = data.charge(its);
+            const PedGainReal* ped = data.pedestal(its);
+            for (unsigned i=0; i<n; ++i)
+            {
+                const double d = q[ch[i]] - ped[ch[i]];
+                qs[i] += d;
+                ts[i] += d*its;
+            }
+        }
+    }
+
+    unsigned minTS_;
+    unsigned maxTS_;
+    double minTime_;
+    double maxTime_;
+};
+
+#endif // ChannelCutSelectors_h_
@@ -0,0 +1,184 @@
+#ifndef ChannelDataSoA_h_
+#define ChannelDataSoA_h_
+
+//
+// Structure-of-arrays view of the per-channel time slice data
+// ("Charge", "Pedestal", and "Gain") of the HCAL noise tree.
+//
+// The tree stores these data as [channel][time slice] arrays, so that
+// any calculation which runs over channels for a fixed time slice has
+// to stride through memory. This class keeps, for every time slice,
+// a contiguous array of length "size()" (the "PulseCount" of the event)
+// for each quantity. Pedestals and gains can be stored in single
+// precision by choosing PedGainReal = float.
+//
+// All arrays live in a single buffer sized by the largest number of
+// channels loaded so far (not by the largest possible event), so that
+// the buffer of a typical job stays small. The buffer is aligned to the
+// cache line size, and so is the start of every array. It is reused for
+// the following events and grows (by at least a half) only when an
+// event with more channels is loaded. Therefore, the pointers returned
+// by "charge", "pedestal", and "gain" are valid only until the next
+// "load" call.
+//
+
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+template <typename PedGainReal = double>
+class ChannelDataSoA
+{
+public:
+    enum {
+        Alignment = 64U
+    };
+
+    // "maxChannels" is the largest number of channels an event can have.
+    // The buffer is made for "initialChannels" channels at first.
+    inline ChannelDataSoA(const unsigned maxChannels,
+                          const unsigned nTimeSlices,
+                          const unsigned initialChannels = 0U)
+        : nSlices_(nTimeSlices),
+          size_(0),
+          capacity_(0),
+          maxChannels_(maxChannels),
+          charge_(0),
+          pedestal_(0),
+          gain_(0)
+    {
+        assert(maxChannels_);
+        assert(nSlices_);
+        allocate(std::max(std::min(initialChannels, maxChannels_), 1U));
+    }
+
+    inline unsigned maxChannels() const {return maxChannels_;}
+    inline unsigned nTimeSlices() const {return nSlices_;}
+
+    // Number of channels which fit into the current buffer
+    inline unsigned capacity() const {return capacity_;}
+
+    // Size of the buffer in bytes
+    inline std::size_t bufferBytes() const {return buffer_.size();}
+
+    // Number of channels in the current event
+    inline unsigned size() const {return size_;}
+
+    // Arrays of length "size()" for the given time slice
+    inline const double* charge(const unsigned ts) const
+        {assert(ts < nSlices_); return charge_ + ts*chargeStride_;}
+
+    inline const PedGainReal* pedestal(const unsigned ts) const
+        {assert(ts < nSlices_); return pedestal_ + ts*pedGainStride_;}
+
+    inline const PedGainReal* gain(const unsigned ts) const
+        {assert(ts < nSlices_); return gain_ + ts*pedGainStride_;}
+
+    // Transpose the data of the first "nChannels" channels from
+    // the [channel][time slice] layout used by the tree. The
+    // number of time slices of the tree arrays must be equal
+    // to "nTimeSlices()".
+    inline void load(const double* treeCharge, const double* treePedestal,
+                     const double* treeGain, const unsigned nChannels)
+    {
+        if (nChannels > maxChannels_)
+            throw std::out_of_range("In ChannelDataSoA::load: "
+                                    "too many channels");
+        if (nChannels > capacity_)
+            allocate(std::min(std::max(nChannels, capacity_ + capacity_/2U),
+                              maxChannels_));
+        for (unsigned ch=0; ch<nChannels; ++ch)
+        {
+            const unsigned k = ch*nSlices_;
+            for (unsigned ts=0; ts<nSlices_; ++ts)
+            {
+                charge_[ts*chargeStride_ + ch] = treeCharge[k + ts];
+                pedestal_[ts*pedGainStride_ + ch] = treePedestal[k + ts];
+                gain_[ts*pedGainStride_ + ch] = treeGain[k + ts];
+            }
+        }
+        size_ = nChannels;
+    }
+
+    // Convenience function for classes generated by the root
+    // "MakeClass" which have "Charge", "Pedestal", "Gain",
+    // and "PulseCount" members
+    template <class TreeData>
+    inline void load(const TreeData& data)
+    {
+        assert(data.PulseCount >= 0);
+        assert(sizeof(data.Charge[0])/sizeof(data.Charge[0][0]) == nSlices_);
+        load(&data.Charge[0][0], &data.Pedestal[0][0], &data.Gain[0][0],
+             data.PulseCount);
+    }
+
+    // "Method 0" energies, summed over time slices from "tsMin"
+    // (included) to "tsMax" (excluded), for all channels.
+    // The "energies" array must have at least "size()" elements.
+    inline void calculateEnergies(const unsigned tsMin, const unsigned tsMax,
+                                  double* energies) const
+    {
+        assert(tsMin <= tsMax);
+        assert(tsMax <= nSlices_);
+        const unsigned n = size_;
+        for (unsigned ch=0; ch<n; ++ch)
+            energies[ch] = 0.0;
+        for (unsigned ts=tsMin; ts<tsMax; ++ts)
+        {
+            const double* q = charge(ts);
+            const PedGainReal* ped = pedestal(ts);
+            const PedGainReal* g = gain(ts);
+            for (unsigned ch=0; ch<n; ++ch)
+                energies[ch] += (q[ch] - ped[ch])*g[ch];
+        }
+    }
+
+private:
+    ChannelDataSoA();
+    ChannelDataSoA(const ChannelDataSoA&);
+    ChannelDataSoA& operator=(const ChannelDataSoA&);
+
+    // Array length rounded up to a multiple of the alignment
+    static inline unsigned paddedLength(const unsigned n,
+                                        const unsigned elementSize)
+    {
+        const unsigned perLine = Alignment/elementSize;
+        return (n + perLine - 1U)/perLine*perLine;
+    }
+
+    // Make a new buffer for the given number of channels. The data
+    // of the previous buffer are not kept.
+    inline void allocate(const unsigned nChannels)
+    {
+        chargeStride_ = paddedLength(nChannels, sizeof(double));
+        pedGainStride_ = paddedLength(nChannels, sizeof(PedGainReal));
+        std::vector<unsigned char>(
+            nSlices_*(chargeStride_*sizeof(double) +
+                      2U*pedGainStride_*sizeof(PedGainReal)) +
+            Alignment).swap(buffer_);
+        unsigned char* base = &buffer_[0];
+        base += (Alignment - reinterpret_cast<std::size_t>(base) %
+                 Alignment) % Alignment;
+        charge_ = reinterpret_cast<double*>(base);
+        pedestal_ = reinterpret_cast<PedGainReal*>(
+            charge_ + nSlices_*chargeStride_);
+        gain_ = pedestal_ + nSlices_*pedGainStride_;
+        capacity_ = nChannels;
+        size_ = 0;
+    }
+
+    unsigned nSlices_;
+    unsigned size_;
+    unsigned capacity_;
+    unsigned chargeStride_;
+    unsigned pedGainStride_;
+    unsigned maxChannels_;
+    std::vector<unsigned char> buffer_;
+    double* charge_;
+    PedGainReal* pedestal_;
+    PedGainReal* gain_;
+};
+
+#endif // ChannelDataSoA_h_
@@ -0,0 +1,138 @@
+#ifndef ChannelSelectorChain_h_
+#define ChannelSelectorChain_h_
+
+//
+// Ordered sequence of channel selectors. Every stage sees only the
+// channels kept by the preceding stages: the list of surviving pulse
+// numbers is passed from stage to stage through the "selectFrom"
+// method of AbsChannelSelector. Once the list becomes empty, only the
+// stages which keep per-event results (see "hasEventResults", e.g.
+// FFTJetChannelSelector) are still run, with the empty list, so that
+// their results (the jets) belong to the current event. Placing cheap
+// cuts (see ChannelCutSelectors.h) in front of expensive selectors
+// reduces the number of channels the expensive selectors have to look
+// at.
+//
+// The "parentPt" of the channels is 0 unless it is set by one of
+// the stages (e.g., FFTJetChannelSelector).
+//
+// The list of channels is taken from the event arena, so the
+// AnalysisClass must provide "eventArena()" (see RootChainProcessor.h).
+//
+
+#include <vector>
+#include <cassert>
+#include <stdexcept>
+
+#include "AbsChannelSelector.h"
+
+template <class AnalysisClass>
+class ChannelSelectorChain : public AbsChannelSelector<AnalysisClass>
+{
+public:
+    inline ChannelSelectorChain() {}
+
+    inline virtual ~ChannelSelectorChain()
+    {
+        for (unsigned i=stages_.size(); i>0; --i)
+            delete stages_[i-1];
+    }
+
+    // Append a stage (the chain takes ownership)
+    inline void add(AbsChannelSelector<AnalysisClass>* stage)
+    {
+        if (!stage)
+            throw std::invalid_argument("In ChannelSelectorChain::add: "
+                                        "NULL stage");
+        stages_.push_back(stage);
+    }
+
+    inline unsigned size() const {return stages_.size();}
+    inline AbsChannelSelector<AnalysisClass>* stage(const unsigned i) const
+        {return stages_.at(i);}
+
+    // Number of channels kept by the given stage in the last event
+    // (0 for the stages which were not run)
+    inline unsigned nKept(const unsigned i) const {return nKept_.at(i);}
+
+    virtual void select(const AnalysisClass& event,
+                        std::vector<unsigned char>* mask,
+                        std::vector<double>* parentPt)
+    {
+        assert(mask);
+        assert(event.PulseCount >= 0);
+        const unsigned n = event.PulseCount;
+        const ArenaAllocator<unsigned> alloc(event.eventArena());
+        ChannelList channels(n, 0U, alloc);
+        for (unsigned i=0; i<n; ++i)
+            channels[i] = i;
+        if (parentPt)
+            parentPt->assign(n, 0.0);
+
+        selectFrom(event, &channels, parentPt);
+
+        mask->assign(n, 0);
+        const unsigned nKept = channels.size();
+        for (unsigned i=0; i<nKept; ++i)
+            (*mask)[channels[i]] = 1;
+    }
+
+    virtual void selectFrom(const AnalysisClass& event,
+                            ChannelList* channels,
+                            std::vector<double>* parentPt)
+    {
+        assert(channels);
+        const unsigned nStages = stages_.size();
+        nKept_.assign(nStages, 0U);
+        for (unsigned i=0; i<nStages; ++i)
+            if (!channels->empty() || stages_[i]->hasEventResults())
+            {
+                stages_[i]->selectFrom(event, channels, parentPt);
+                nKept_[i] = channels->size();
+            }
+    }
+
+    virtual bool hasEventResults() const
+    {
+        const unsigned nStages = stages_.size();
+        for (unsigned i=0; i<nStages; ++i)
+            if (stages_[i]->hasEventResults())
+                return true;
+        return false;
+    }
+
+    // Every stage gets the whole batch, even though the preceding
+    // stages may leave it no channels in some events
+    virtual void addToBatch(const AnalysisClass& event)
+    {
+        const unsigned nStages = stages_.size();
+        for (unsigned i=0; i<nStages; ++i)
+            stages_[i]->addToBatch(event);
+    }
+
+    virtual void submitBatch()
+    {
+        const unsigned nStages = stages_.size();
+        for (unsigned i=0; i<nStages; ++i)
+            stages_[i]->submitBatch();
+    }
+
+    virtual std::size_t scratchBytes() const
+    {
+        std::size_t sum = AbsChannelSelector<AnalysisClass>::scratchBytes() +
+                          this->vectorBytes(nKept_);
+        const unsigned nStages = stages_.size();
+        for (unsigned i=0; i<nStages; ++i)
+            sum += stages_[i]->scratchBytes();
+        return sum;
+    }
+
+private:
+    ChannelSelectorChain(const ChannelSelectorChain&);
+    ChannelSelectorChain& operator=(const ChannelSelectorChain&);
+
+    std::vector<AbsChannelSelector<AnalysisClass>*> stages_;
+    std::vector<unsigned> nKept_;
+};
+
+#endif // ChannelSelectorChain_h_
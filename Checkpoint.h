@@ -0,0 +1,148 @@
+#ifndef Checkpoint_h_
+#define Checkpoint_h_
+
+//
+// Description of the progress of a job which checkpoints its output
+// (see RootChainProcessor::setCheckpointing). Every checkpoint writes
+// all managed histograms and ntuples into the output file, together
+// with this record: the "Checkpoint" tree with one entry and the
+// "CheckpointInputFile" and "CheckpointConfiguration" TNamed objects
+// (the input file being processed and the job configuration string,
+// in their titles). The record is removed when the job finishes, so
+// its presence means that the output belongs to an unfinished job
+// which can be resumed from the entry "nextEntry" with the "--resume"
+// option of the executables made from "analysisExecutableTemplate.C".
+//
+
+#include <string>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TNamed.h"
+
+struct CheckpointInfo
+{
+    inline CheckpointInfo()
+        : firstEntry(0), nextEntry(0), lastEntry(0),
+          eventsRead(0), eventsProcessed(0)
+    {
+    }
+
+    // Range of chain entries assigned to the job, first included,
+    // last excluded, and the first entry not yet processed
+    Long64_t firstEntry;
+    Long64_t nextEntry;
+    Long64_t lastEntry;
+
+    // Numbers of entries read and accepted by the cut
+    // from "firstEntry" to "nextEntry"
+    Long64_t eventsRead;
+    Long64_t eventsProcessed;
+
+    // Input file containing the entry "nextEntry - 1"
+    std::string inputFile;
+
+    // Job configuration (as written into the "JobConfiguration" record).
+    // A job can be resumed only with the same configuration.
+    std::string configuration;
+};
+
+namespace Private {
+    inline void bindCheckpointBranches(TTree* tree, CheckpointInfo* info,
+                                       const bool create)
+    {
+        struct BranchDef {const char* name; void* addr; const char* leaf;};
+        const BranchDef defs[] = {
+            {"firstEntry",      &info->firstEntry,      "firstEntry/L"},
+            {"nextEntry",       &info->nextEntry,       "nextEntry/L"},
+            {"lastEntry",       &info->lastEntry,       "lastEntry/L"},
+            {"eventsRead",      &info->eventsRead,      "eventsRead/L"},
+            {"eventsProcessed", &info->eventsProcessed, "eventsProcessed/L"}
+        };
+        const unsigned nDefs = sizeof(defs)/sizeof(defs[0]);
+        for (unsigned i=0; i<nDefs; ++i)
+        {
+            if (create)
+                tree->Branch(defs[i].name, defs[i].addr, defs[i].leaf);
+            else if (tree->SetBranchAddress(defs[i].name, defs[i].addr) < 0)
+            {
+                std::ostringstream os;
+                os << "In bindCheckpointBranches: branch \"" << defs[i].name
+                   << "\" not found in the Checkpoint tree";
+                throw std::runtime_error(os.str());
+            }
+        }
+    }
+}
+
+// Write the checkpoint record into the top directory of the given
+// file, replacing the previous record
+inline void writeCheckpointInfo(TFile& file, const CheckpointInfo& infoIn)
+{
+    file.cd();
+    CheckpointInfo info(infoIn);
+    TTree* tree = new TTree("Checkpoint", "Progress of an unfinished job");
+    Private::bindCheckpointBranches(tree, &info, true);
+    tree->Fill();
+    tree->Write(0, TObject::kOverwrite);
+    delete tree;
+    TNamed input("CheckpointInputFile", info.inputFile.c_str());
+    input.Write(0, TObject::kOverwrite);
+    TNamed config("CheckpointConfiguration", info.configuration.c_str());
+    config.Write(0, TObject::kOverwrite);
+}
+
+inline void removeCheckpointInfo(TFile& file)
+{
+    file.Delete("Checkpoint;*");
+    file.Delete("CheckpointInputFile;*");
+    file.Delete("CheckpointConfiguration;*");
+}
+
+// Returns false if the file has no checkpoint record
+inline bool readCheckpointInfo(TFile& file, CheckpointInfo* info)
+{
+    assert(info);
+    *info = CheckpointInfo();
+    TTree* tree = 0;
+    file.GetObject("Checkpoint", tree);
+    if (!tree)
+        return false;
+    Private::bindCheckpointBranches(tree, info, false);
+    const bool ok = tree->GetEntries() == 1 && tree->GetEntry(0) > 0;
+    delete tree;
+    if (!ok)
+        return false;
+    TNamed* named = 0;
+    file.GetObject("CheckpointInputFile", named);
+    if (named)
+    {
+        info->inputFile = named->GetTitle();
+        delete named;
+        named = 0;
+    }
+    file.GetObject("CheckpointConfiguration", named);
+    if (!named)
+        return false;
+    info->configuration = named->GetTitle();
+    delete named;
+    return true;
+}
+
+// Read the checkpoint record from the named file. Returns false
+// if the file can not be opened or has no checkpoint record.
+inline bool readCheckpointInfo(const std::string& filename,
+                               CheckpointInfo* info)
+{
+    TFile file(filename.c_str(), "READ");
+    if (!file.IsOpen() || file.IsZombie())
+        return false;
+    const bool status = readCheckpointInfo(file, info);
+    file.Close();
+    return status;
+}
+
+#endif // Checkpoint_h_
@@ -2,13 +2,19 @@
 #define Column_h_
 
 //
-// Column definition helper function for use with AutoNtuple, AutoNtupleD,
-// CycledNtuple, and CycledNtupleD.
+// Column definition helper functions for use with AutoNtuple, AutoNtupleD,
+// CycledNtuple, and CycledNtupleD. "Column" functions are also usable
+// with AutoTree, CycledTree, and CycledArrayTree.
 //
 // I. Volobouev
 // March 2013
 //
 
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cassert>
+
 //
 // In the user code, do not create instances of ColumnHelper class
 // directly, use the "Column" function instead
@@ -29,6 +35,74 @@ inline ColumnHelper<Functor> Column(const std::string& iName, Functor ifcn)
     return ColumnHelper<Functor>(iName, ifcn);
 }
 
+//
+// Columns made out of "length" contiguous array elements. In the cycled
+// mode, the elements for cycle i start at data[i*stride]. The ntuple
+// columns are named name0, name1, ..., and they are filled with one
+// bulk copy (with type conversion, if necessary). For example, the time
+// slice charges ts0, ts1, ..., ts9 of the noise tree can be defined by
+// ArrayColumn("ts", &this->Charge[0][0], 10).
+//
+// In the user code, do not create instances of ArrayColumnHelper class
+// directly, use the "ArrayColumn" or "VectorColumn" functions instead.
+//
+template<typename T>
+struct ArrayColumnHelper
+{
+    inline ArrayColumnHelper(const std::string& iName, const T* iData,
+                             const std::vector<T>* iVec,
+                             const unsigned iLength, const unsigned iStride)
+        : name(iName), ptr(iData), vec(iVec), length(iLength), stride(iStride)
+    {
+        assert(ptr || vec);
+        assert(length);
+    }
+
+    // Names of all columns, separated by ':'
+    inline std::string columnNames() const
+    {
+        std::ostringstream os;
+        for (unsigned i=0; i<length; ++i)
+            os << (i ? ":" : "") << name << i;
+        return os.str();
+    }
+
+    inline const T* data(const unsigned cycle) const
+    {
+        const T* d = ptr ? ptr : &(*vec)[0];
+        return d + cycle*stride;
+    }
+
+    std::string name;
+    const T* ptr;
+    const std::vector<T>* vec;
+    unsigned length;
+    unsigned stride;
+};
+
+template<typename T>
+inline ArrayColumnHelper<T> ArrayColumn(const std::string& iName,
+                                        const T* data, const unsigned length,
+                                        const unsigned stride=0)
+{
+    return ArrayColumnHelper<T>(iName, data, 0, length,
+                                stride ? stride : length);
+}
+
+//
+// Same thing for the data kept in a vector. The vector may be
+// reallocated between the fills, but it must be sufficiently long.
+//
+template<typename T>
+inline ArrayColumnHelper<T> VectorColumn(const std::string& iName,
+                                         const std::vector<T>& data,
+                                         const unsigned length,
+                                         const unsigned stride=0)
+{
+    return ArrayColumnHelper<T>(iName, 0, &data, length,
+                                stride ? stride : length);
+}
+
 //
 // Convenience macro for variables that either already exist in a root tree
 // we are processing or belong to the analysis class
@@ -7,11 +7,19 @@
 // Use the "CycledH2D" helper function to create instances of this
 // wrapper.
 //
+// The values and weights of one "CycleFill" call are collected into
+// contiguous arrays and passed to root with a single "FillN" call.
+// Cycles with zero weight are not passed to root at all.
+//
 // I. Volobouev
 // March 2013
 //
 
+#include <memory>
+
 #include "ManagedHisto.h"
+#include "SharedHisto.h"
+#include "zeroWeightFills.h"
 #include "TH2D.h"
 
 //
@@ -34,7 +42,8 @@ public:
           f1_(quantity1),
           f2_(quantity2),
           w_(weight),
-          directory_(directory ? directory : "")
+          directory_(directory ? directory : ""),
+          nSkipped_(0)
     {
         histo_->GetXaxis()->SetTitle(xlabel);
         histo_->GetYaxis()->SetTitle(ylabel);
@@ -50,19 +59,73 @@ public:
     inline void AutoFill() {}
     inline void CycleFill(const unsigned nCycles)
     {
+        BeginCycles();
+        xBuf_.reserve(nCycles);
+        yBuf_.reserve(nCycles);
+        wBuf_.reserve(nCycles);
         for (unsigned i=0; i<nCycles; ++i)
-            histo_->Fill(f1_(i), f2_(i), w_(i));
+            FillCycle(i);
+        EndCycles();
+    }
+
+    // Single-cycle interface used by FusedCycledSet
+    inline void BeginCycles()
+    {
+        xBuf_.clear();
+        yBuf_.clear();
+        wBuf_.clear();
+        nSkipped_ = 0;
+    }
+    inline void FillCycle(const unsigned i)
+    {
+        const double w = w_(i);
+        if (w)
+        {
+            xBuf_.push_back(f1_(i));
+            yBuf_.push_back(f2_(i));
+            wBuf_.push_back(w);
+        }
+        else
+            ++nSkipped_;
     }
+    inline void EndCycles()
+    {
+        if (shared_)
+        {
+            const unsigned n = xBuf_.size();
+            for (unsigned i=0; i<n; ++i)
+                shared_->fill(xBuf_[i], yBuf_[i], wBuf_[i]);
+            shared_->recordZeroWeightFills(nSkipped_);
+            return;
+        }
+        if (!xBuf_.empty())
+            histo_->FillN(xBuf_.size(), &xBuf_[0], &yBuf_[0], &wBuf_[0]);
+        recordZeroWeightFills(histo_, nSkipped_);
+    }
+
     inline void SetDirectory(TDirectory* d) {histo_->SetDirectory(d);}
     inline const std::string& GetDirectoryName() const {return directory_;}
     inline TH2D* GetRootItem() const {return histo_;}
 
+    inline bool ShareBins(SharedHistoStore& store, const bool owner)
+    {
+        shared_.reset(new SharedHistoFiller(store, histo_, directory_, owner));
+        return true;
+    }
+
 private:
     TH2D* histo_;    
     Functor1 f1_;
     Functor2 f2_;
     Functor3 w_;
     std::string directory_;
+
+    // Staging buffers for "FillN"
+    std::vector<double> xBuf_;
+    std::vector<double> yBuf_;
+    std::vector<double> wBuf_;
+    std::unique_ptr<SharedHistoFiller> shared_;
+    unsigned nSkipped_;
 };
 
 //
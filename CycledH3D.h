@@ -7,11 +7,18 @@
 // Use the "CycledH3D" helper function to create instances of this
 // wrapper.
 //
+// Cycles with zero weight are not passed to root (their effect on
+// the histogram is accounted for by "recordZeroWeightFills").
+//
 // I. Volobouev
 // March 2013
 //
 
+#include <memory>
+
 #include "ManagedHisto.h"
+#include "SharedHisto.h"
+#include "zeroWeightFills.h"
 #include "TH3D.h"
 
 //
@@ -38,7 +45,8 @@ public:
           f2_(quantity2),
           f3_(quantity3),
           w_(weight),
-          directory_(directory ? directory : "")
+          directory_(directory ? directory : ""),
+          nSkipped_(0)
     {
         histo_->GetXaxis()->SetTitle(xlabel);
         histo_->GetYaxis()->SetTitle(ylabel);
@@ -60,13 +68,46 @@ public:
     inline void AutoFill() {}
     inline void CycleFill(const unsigned nCycles)
     {
+        BeginCycles();
         for (unsigned i=0; i<nCycles; ++i)
-            histo_->Fill(f1_(i), f2_(i), f3_(i), w_(i));
+            FillCycle(i);
+        EndCycles();
+    }
+
+    // Single-cycle interface used by FusedCycledSet. TH3 has no
+    // usable "FillN", so only the zero-weight fills are skipped.
+    inline void BeginCycles() {nSkipped_ = 0;}
+    inline void FillCycle(const unsigned i)
+    {
+        const double w = w_(i);
+        if (w)
+        {
+            if (shared_)
+                shared_->fill(f1_(i), f2_(i), f3_(i), w);
+            else
+                histo_->Fill(f1_(i), f2_(i), f3_(i), w);
+        }
+        else
+            ++nSkipped_;
     }
+    inline void EndCycles()
+    {
+        if (shared_)
+            shared_->recordZeroWeightFills(nSkipped_);
+        else
+            recordZeroWeightFills(histo_, nSkipped_);
+    }
+
     inline void SetDirectory(TDirectory* d) {histo_->SetDirectory(d);}
     inline const std::string& GetDirectoryName() const {return directory_;}
     inline TH3D* GetRootItem() const {return histo_;}
 
+    inline bool ShareBins(SharedHistoStore& store, const bool owner)
+    {
+        shared_.reset(new SharedHistoFiller(store, histo_, directory_, owner));
+        return true;
+    }
+
 private:
     TH3D* histo_;    
     Functor1 f1_;
@@ -74,6 +115,8 @@ private:
     Functor3 f3_;
     Functor4 w_;
     std::string directory_;
+    std::unique_ptr<SharedHistoFiller> shared_;
+    unsigned nSkipped_;
 };
 
 //
@@ -54,6 +54,15 @@ public:
             if (sel_(i))
                 fillNtupleWithCycledPacker(nt_, &buffer_[0], packer_, i);
     }
+
+    // Single-cycle interface used by FusedCycledSet
+    inline void BeginCycles() {}
+    inline void FillCycle(const unsigned i)
+    {
+        if (sel_(i))
+            fillNtupleWithCycledPacker(nt_, &buffer_[0], packer_, i);
+    }
+    inline void EndCycles() {}
     inline void SetDirectory(TDirectory* d) {nt_->SetDirectory(d);}
     inline const std::string& GetDirectoryName() const {return directory_;}
     inline Ntuple* GetRootItem() const {return nt_;}
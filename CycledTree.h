@@ -0,0 +1,227 @@
+#ifndef CycledTree_h_
+#define CycledTree_h_
+
+//
+// Wrapper templates for TTree which implement ManagedHisto interface
+// and know how to fill the trees automatically in a cycle. The branch
+// type of every column is determined by the type returned by the column
+// functor (see TreePacker.h).
+//
+// CycledTree makes one tree entry per selected cycle, like CycledNtuple.
+//
+// CycledArrayTree makes one tree entry per "CycleFill" call (normally,
+// one entry per event). Every column becomes a variable-length array
+// branch whose elements correspond to the selected cycles. The number
+// of selected cycles is stored in an additional Int_t branch, with
+// the name given as the "counter" argument. For per-channel data,
+// this layout is much more compact than one entry per channel.
+//
+// Use the helper functions "CycledTree" and "CycledArrayTree" to create
+// instances of these classes.
+//
+
+#include "ManagedHisto.h"
+#include "TreePacker.h"
+#include "Column.h"
+#include "AllPass.h"
+
+//
+// In the user code, do not create instances of this class directly,
+// call the "CycledTree" function instead
+//
+template <class TreePacker, typename Selector>
+class CycledTreeHelper : public ManagedHisto
+{
+public:
+    CycledTreeHelper(const char* name, const char* title,
+                     const char* directory, const TreePacker& packer,
+                     const Selector& selector)
+        : tree_(0),
+          directory_(directory),
+          packer_(packer),
+          sel_(selector)
+    {
+        tree_ = new TTree(name, title);
+        Cycler::book(tree_, packer_, buffers_, 0);
+    }
+
+    inline virtual ~CycledTreeHelper()
+    {
+        // Do not delete tree_ here due to the idiosyncratic
+        // root object ownership conventions
+    }
+
+    inline void AutoFill() {}
+    inline void CycleFill(const unsigned nCycles)
+    {
+        for (unsigned i=0; i<nCycles; ++i)
+            if (sel_(i))
+            {
+                Cycler::fill(packer_, buffers_, i);
+                tree_->Fill();
+            }
+    }
+
+    // Single-cycle interface used by FusedCycledSet
+    inline void BeginCycles() {}
+    inline void FillCycle(const unsigned i)
+    {
+        if (sel_(i))
+        {
+            Cycler::fill(packer_, buffers_, i);
+            tree_->Fill();
+        }
+    }
+    inline void EndCycles() {}
+    inline void SetDirectory(TDirectory* d) {tree_->SetDirectory(d);}
+    inline const std::string& GetDirectoryName() const {return directory_;}
+    inline TTree* GetRootItem() const {return tree_;}
+
+private:
+    typedef typename tupleutils::TreeBufferTuple<TreePacker,true>::type Buffers;
+    typedef tupleutils::TreeBranchCycler<
+        TreePacker,Buffers,std::tuple_size<TreePacker>::value> Cycler;
+
+    // Branches keep the addresses of the buffers
+    CycledTreeHelper(const CycledTreeHelper&);
+    CycledTreeHelper& operator=(const CycledTreeHelper&);
+
+    TTree* tree_;
+    std::string directory_;
+    TreePacker packer_;
+    Buffers buffers_;
+    Selector sel_;
+};
+
+//
+// In the user code, do not create instances of this class directly,
+// call the "CycledArrayTree" function instead
+//
+template <class TreePacker, typename Selector>
+class CycledArrayTreeHelper : public ManagedHisto
+{
+public:
+    CycledArrayTreeHelper(const char* name, const char* title,
+                          const char* directory, const char* counter,
+                          const TreePacker& packer, const Selector& selector)
+        : tree_(0),
+          directory_(directory),
+          count_(0),
+          packer_(packer),
+          sel_(selector)
+    {
+        assert(counter);
+        tree_ = new TTree(name, title);
+        const std::string leaves = std::string(counter) + "/I";
+        tree_->Branch(counter, &count_, leaves.c_str());
+        Cycler::book(tree_, packer_, buffers_, counter);
+    }
+
+    inline virtual ~CycledArrayTreeHelper()
+    {
+        // Do not delete tree_ here due to the idiosyncratic
+        // root object ownership conventions
+    }
+
+    inline void AutoFill() {}
+    inline void CycleFill(const unsigned nCycles)
+    {
+        BeginCycles();
+        for (unsigned i=0; i<nCycles; ++i)
+            FillCycle(i);
+        EndCycles();
+    }
+
+    // Single-cycle interface used by FusedCycledSet
+    inline void BeginCycles()
+    {
+        Cycler::clearArrays(buffers_);
+        count_ = 0;
+    }
+    inline void FillCycle(const unsigned i)
+    {
+        if (sel_(i))
+        {
+            Cycler::append(packer_, buffers_, i);
+            ++count_;
+        }
+    }
+    inline void EndCycles()
+    {
+        Cycler::updateArrayAddresses(buffers_);
+        tree_->Fill();
+    }
+    inline void SetDirectory(TDirectory* d) {tree_->SetDirectory(d);}
+    inline const std::string& GetDirectoryName() const {return directory_;}
+    inline TTree* GetRootItem() const {return tree_;}
+
+private:
+    typedef typename tupleutils::TreeBufferTuple<TreePacker,true>::type Buffers;
+    typedef tupleutils::TreeBranchCycler<
+        TreePacker,Buffers,std::tuple_size<TreePacker>::value> Cycler;
+
+    // Branches keep the addresses of the buffers
+    CycledArrayTreeHelper(const CycledArrayTreeHelper&);
+    CycledArrayTreeHelper& operator=(const CycledArrayTreeHelper&);
+
+    TTree* tree_;
+    std::string directory_;
+    Int_t count_;
+    TreePacker packer_;
+    Buffers buffers_;
+    Selector sel_;
+};
+
+//
+// TreePacker template parameter is an std::tuple of ColumnHelper objects.
+// Functors inside ColumnHelpers must implement "operator()(unsigned)" which
+// returns bool, an integer type, float, or double.
+//
+// Selector template parameter is a functor which implements
+// "operator()(unsigned)" whose result is bool or can be converted to bool.
+// If the result returned by this operator is "true", the tree will be
+// filled (CycledTree) or the array elements will be added (CycledArrayTree)
+// for this cycle.
+//
+// Other arguments have the same meaning as for CycledNtuple.
+//
+template<class TreePacker, class Selector>
+inline CycledTreeHelper<TreePacker, Selector>* CycledTree(
+    const char* name, const char* title,
+    const char* directory, const TreePacker& packer,
+    const Selector& selector)
+{
+    return new CycledTreeHelper<TreePacker, Selector>(
+        name, title, directory, packer, selector);
+}
+
+template<class TreePacker>
+inline CycledTreeHelper<TreePacker, AllPass>* CycledTree(
+    const char* name, const char* title,
+    const char* directory, const TreePacker& packer)
+{
+    return new CycledTreeHelper<TreePacker, AllPass>(
+        name, title, directory, packer, AllPass());
+}
+
+template<class TreePacker, class Selector>
+inline CycledArrayTreeHelper<TreePacker, Selector>* CycledArrayTree(
+    const char* name, const char* title,
+    const char* directory, const char* counter,
+    const TreePacker& packer, const Selector& selector)
+{
+    return new CycledArrayTreeHelper<TreePacker, Selector>(
+        name, title, directory, counter, packer, selector);
+}
+
+template<class TreePacker>
+inline CycledArrayTreeHelper<TreePacker, AllPass>* CycledArrayTree(
+    const char* name, const char* title,
+    const char* directory, const char* counter,
+    const TreePacker& packer)
+{
+    return new CycledArrayTreeHelper<TreePacker, AllPass>(
+        name, title, directory, counter, packer, AllPass());
+}
+
+#endif // CycledTree_h_
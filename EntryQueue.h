@@ -0,0 +1,91 @@
+#ifndef EntryQueue_h_
+#define EntryQueue_h_
+
+//
+// Chain entries queued by an analysis which processes its events in
+// batches (see the "--eventBatch" option of SelectGoodChannels). The
+// queue does not span the trees of the chain, so that it can normally
+// be processed without reopening the input files: it is processed when
+// it is full, when the last entry of the current tree is added, and
+// before an entry of another tree is added. The last case happens when
+// the final entries of a tree do not pass the event cut. By then, the
+// chain has already moved on to the new tree. The queued entries are
+// then reloaded from the previous file, and the new entry is reloaded
+// after them.
+//
+// The "Owner" class must provide the methods
+//
+//   void entryQueued(long long entry);
+//   int processQueuedEntries(const std::vector<long long>& entries);
+//   void reloadEntry(long long entry);
+//
+// The first one is called after the entry is added to the queue, while
+// the entry is still current, so that the owner can take from the tree
+// buffers what it needs for the batch (e.g., fill the energy flow grids
+// of the batched convolutions). The second one processes the given
+// entries, in order, and returns the status of the processing (0 on
+// success). It may load these entries into the tree buffers. The third
+// one must make the given entry current again.
+//
+
+#include <vector>
+#include <cassert>
+
+template <class Owner>
+class EntryQueue
+{
+public:
+    inline explicit EntryQueue(Owner& owner, const unsigned maxSize = 1U)
+        : owner_(owner), maxSize_(maxSize), tree_(-1) {assert(maxSize_);}
+
+    inline void setMaxSize(const unsigned maxSize)
+        {assert(maxSize); maxSize_ = maxSize;}
+
+    inline unsigned maxSize() const {return maxSize_;}
+    inline unsigned size() const {return entries_.size();}
+    inline bool empty() const {return entries_.empty();}
+    inline const std::vector<long long>& entries() const {return entries_;}
+
+    // Queue the current entry of the chain. "treeNumber" is the number
+    // of the chain tree the entry belongs to, and "lastInTree" tells
+    // whether it is the last entry of that tree. Returns the status of
+    // the queue processing (0 if the queue was not processed).
+    inline int add(const long long entry, const int treeNumber,
+                   const bool lastInTree)
+    {
+        int status = 0;
+        if (!entries_.empty() && treeNumber != tree_)
+        {
+            status = process();
+            owner_.reloadEntry(entry);
+        }
+        entries_.push_back(entry);
+        tree_ = treeNumber;
+        owner_.entryQueued(entry);
+        if (!status && (lastInTree || entries_.size() >= maxSize_))
+            status = process();
+        return status;
+    }
+
+    // Process the queued entries (if any) and clear the queue
+    inline int process()
+    {
+        if (entries_.empty())
+            return 0;
+        const int status = owner_.processQueuedEntries(entries_);
+        entries_.clear();
+        return status;
+    }
+
+private:
+    EntryQueue();
+    EntryQueue(const EntryQueue&);
+    EntryQueue& operator=(const EntryQueue&);
+
+    Owner& owner_;
+    std::vector<long long> entries_;
+    unsigned maxSize_;
+    int tree_;
+};
+
+#endif // EntryQueue_h_
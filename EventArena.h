@@ -0,0 +1,233 @@
+#ifndef EventArena_h_
+#define EventArena_h_
+
+//
+// Bump allocator for scratch data which lives for one event only.
+//
+// Memory is handed out from large blocks by advancing a pointer and is
+// never returned individually: the whole arena is recycled at once
+// by "reset". RootChainProcessor owns one arena and resets it before
+// every call of the "event" method, so the analysis code (and the
+// channel selectors, which get the analysis object) can use it via
+// "eventArena()" for per-event temporaries. In the multithreaded mode
+// every processor has its own arena, so the threads do not contend
+// for the heap.
+//
+// If an event needs more memory than the current block provides, new
+// blocks are allocated. At the next "reset", these blocks are replaced
+// by a single block large enough for the whole event, so that after a
+// few events the arena stops calling the heap entirely.
+//
+// ArenaAllocator is a standard-conforming allocator which takes its
+// memory from an arena. Containers using it (for example, ArenaVector)
+// must not outlive the "reset" of the arena: declare them locally
+// in the "event" method or in the code called from it.
+//
+// I. Volobouev
+// October 2016
+//
+
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <cassert>
+#include <cstdlib>
+
+class EventArena
+{
+public:
+    enum {
+        DefaultBlockSize = 1U << 20
+    };
+
+    inline explicit EventArena(const std::size_t blockSize = DefaultBlockSize)
+        : blockSize_(blockSize ? blockSize : 1U),
+          current_(0),
+          used_(0),
+          highWater_(0)
+    {
+    }
+
+    inline ~EventArena() {release();}
+
+    // Allocate "bytes" bytes aligned at "alignment" (a power of 2)
+    inline void* allocate(const std::size_t bytes,
+                          const std::size_t alignment = alignof(std::max_align_t))
+    {
+        assert(alignment && !(alignment & (alignment - 1U)));
+        if (!blocks_.empty())
+        {
+            Block& b(blocks_[current_]);
+            const std::size_t pos = alignUp(b.data, b.used, alignment);
+            if (pos + bytes <= b.size)
+            {
+                b.used = pos + bytes;
+                used_ += bytes;
+                return b.data + pos;
+            }
+        }
+        return allocateFromNewBlock(bytes, alignment);
+    }
+
+    // Memory is normally not returned. However, if the released
+    // piece is the last one allocated, the space is reused (this
+    // helps containers which grow by reallocation).
+    inline void deallocate(void* p, const std::size_t bytes)
+    {
+        if (p && !blocks_.empty())
+        {
+            Block& b(blocks_[current_]);
+            char* c = static_cast<char*>(p);
+            if (c + bytes == b.data + b.used)
+            {
+                b.used -= bytes;
+                used_ -= bytes;
+            }
+        }
+    }
+
+    // Make all memory available again. Everything allocated
+    // from the arena becomes invalid.
+    inline void reset()
+    {
+        std::size_t total = 0;
+        for (unsigned i=0; i<blocks_.size(); ++i)
+            total += blocks_[i].used;
+        if (total > highWater_)
+            highWater_ = total;
+        if (blocks_.size() > 1U)
+        {
+            // Coalesce into one block large enough for the largest event
+            release();
+            std::size_t size = blockSize_;
+            while (size < highWater_)
+                size *= 2U;
+            addBlock(size);
+        }
+        else if (!blocks_.empty())
+            blocks_[0].used = 0;
+        current_ = 0;
+        used_ = 0;
+    }
+
+    // Bytes handed out since the last reset
+    inline std::size_t bytesUsed() const {return used_;}
+
+    // Largest number of bytes used between two resets
+    inline std::size_t highWaterMark() const
+        {return used_ > highWater_ ? used_ : highWater_;}
+
+    // Total size of the blocks currently held
+    inline std::size_t capacity() const
+    {
+        std::size_t total = 0;
+        for (unsigned i=0; i<blocks_.size(); ++i)
+            total += blocks_[i].size;
+        return total;
+    }
+
+private:
+    EventArena(const EventArena&);
+    EventArena& operator=(const EventArena&);
+
+    struct Block
+    {
+        char* data;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    static inline std::size_t alignUp(const char* base, const std::size_t pos,
+                                      const std::size_t alignment)
+    {
+        const std::size_t addr = reinterpret_cast<std::size_t>(base) + pos;
+        return pos + ((alignment - addr % alignment) % alignment);
+    }
+
+    inline void addBlock(const std::size_t size)
+    {
+        Block b;
+        b.data = static_cast<char*>(std::malloc(size));
+        if (!b.data)
+            throw std::bad_alloc();
+        b.size = size;
+        b.used = 0;
+        blocks_.push_back(b);
+    }
+
+    inline void* allocateFromNewBlock(const std::size_t bytes,
+                                      const std::size_t alignment)
+    {
+        // Move on to the next block if it is big enough,
+        // otherwise make a new one
+        const std::size_t needed = bytes + alignment;
+        if (current_ + 1U < blocks_.size() &&
+            blocks_[current_ + 1U].size >= needed)
+            ++current_;
+        else
+        {
+            addBlock(needed > blockSize_ ? needed : blockSize_);
+            current_ = blocks_.size() - 1U;
+        }
+        Block& b(blocks_[current_]);
+        const std::size_t pos = alignUp(b.data, b.used, alignment);
+        assert(pos + bytes <= b.size);
+        b.used = pos + bytes;
+        used_ += bytes;
+        return b.data + pos;
+    }
+
+    inline void release()
+    {
+        for (unsigned i=0; i<blocks_.size(); ++i)
+            std::free(blocks_[i].data);
+        blocks_.clear();
+    }
+
+    std::size_t blockSize_;
+    std::vector<Block> blocks_;
+    unsigned current_;
+    std::size_t used_;
+    std::size_t highWater_;
+};
+
+
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    inline explicit ArenaAllocator(EventArena& arena) : arena_(&arena) {}
+
+    template <typename U>
+    inline ArenaAllocator(const ArenaAllocator<U>& r) : arena_(r.arena()) {}
+
+    inline T* allocate(const std::size_t n)
+        {return static_cast<T*>(arena_->allocate(n*sizeof(T), alignof(T)));}
+
+    inline void deallocate(T* p, const std::size_t n)
+        {arena_->deallocate(p, n*sizeof(T));}
+
+    inline EventArena* arena() const {return arena_;}
+
+    template <typename U>
+    inline bool operator==(const ArenaAllocator<U>& r) const
+        {return arena_ == r.arena();}
+
+    template <typename U>
+    inline bool operator!=(const ArenaAllocator<U>& r) const
+        {return arena_ != r.arena();}
+
+private:
+    ArenaAllocator();
+
+    EventArena* arena_;
+};
+
+// Vector whose buffer comes from an arena. Construct it with
+// the allocator, e.g. ArenaVector<double> v(ArenaAllocator<double>(a)).
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+#endif // EventArena_h_
@@ -12,6 +12,10 @@
 
 #include "RootChainProcessor.h"
 #include "HistogramManager.h"
+#include "FusedCycledSet.h"
+#include "CycledH1D.h"
+#include "CycledH2D.h"
+#include "Functors.h"
 
 // The class template parameters are:
 // 
@@ -74,10 +78,26 @@ public:
     // "Notify" if you want a notification when a new file is opened in
     // the TChain, and override "Cut" if some events should be skipped
     // (the "event" method will not be called if "Cut" returns a negative
-    // number).
+    // number). If "Cut" uses only a few small branches, declare them
+    // in the constructor with "requireCutBranch" (see RootChainProcessor.h),
+    // so that the remaining branches are read for accepted events only.
     virtual Bool_t Notify();
     virtual Int_t Cut(Long64_t entryNumber);
 
+    // Merge the results accumulated by another instance of this
+    // class which processed a different part of the input chain.
+    // Used in the multithreaded mode.
+    virtual int mergeResults(RootChainProcessor<RootMadeClass>& other);
+
+    // Save the managed histograms and ntuples with the checkpoint record
+    virtual int writeCheckpoint(const CheckpointInfo& info);
+
+    // Publish the managed histograms in the streaming mode
+    virtual int writeSnapshot(SnapshotPublisher& publisher);
+
+    // Add the memory of the managed histograms and ntuples
+    virtual void reportMemory(MemoryUsage& usage) const;
+
 protected:
     //
     // The methods "beginJob", "event", and "endJob" must be implemented
@@ -112,11 +132,27 @@ private:
     const Options options_;
     const bool verbose_;
 
-    // The histogram manager
+    // The histogram manager and the handle of the "HBHE" group
     HistogramManager manager_;
+    HistogramManager::GroupHandle hbheGroup_;
+
+    // Per-channel histograms filled together, in one pass over
+    // the channels. Pointers to the histograms which were not
+    // requested remain null.
+    typedef CycledH1DHelper<MemberFcnHlp1Const<double,NoiseTreeHelper>,
+                            Double> EnergyHisto;
+    typedef CycledH2DHelper<ElementOfHlp<Int_t>,ElementOfHlp<Int_t>,
+                            ElementEQHlp<Int_t> > OccupancyHisto;
+    FusedCycledSet<EnergyHisto,OccupancyHisto> fusedHBHE_;
 
     // Quantities which will be calculated by the analysis
     double totalEnergy_;
+
+    // Set to "true" if some of the booked items use "totalEnergy_"
+    bool needTotalEnergy_;
+
+    // Timed stage (see RootChainProcessor::enableTiming)
+    unsigned fillStage_;
 };
 
 #include "ExampleAnalysis.icc"
@@ -20,8 +20,9 @@
 // 5) Method "void usage(std::ostream& os) const" for printing usage
 //    instructions
 //
-// Preferably, this class should also have "operator<<" for printing
-// the option values actually used.
+// This class must also have "operator<<" for printing the option
+// values actually used (the main program stores this printout in
+// the output file, see JobInfo.h).
 //
 // This class works in tandem with the analysis class.
 // ExampleAnalysisOptions object is a "const" member in the analysis
@@ -35,11 +36,17 @@
 //
 // Do not use here switches reserved for use by the main program.
 // These switches are:
+//   "-a", "--asyncPrefetch"
+//   "-b", "--branches"
+//   "-c", "--cacheSize"
 //   "-h", "--histogram"
+//   "-j", "--threads"
 //   "-n", "--maxEvents"
 //   "-s", "--noStats"
 //   "-t", "--treeName"
+//   "-u", "--parallelUnzip"
 //   "-v", "--verbose"
+//   "--firstEvent", "--shard", "--fileShard", "--timing"
 //
 struct ExampleAnalysisOptions
 {
@@ -0,0 +1,65 @@
+#ifndef FFTJetBatchConvolver_h_
+#define FFTJetBatchConvolver_h_
+
+//
+// FFTJet convolver which can hand over a convolution made elsewhere
+// (for example, by an AbsFFTJetBatchBackend) to the FFTJet pattern
+// recognition sequence instead of calculating it. When no precomputed
+// result is set, it works exactly like FrequencyKernelConvolver, so
+// that it also serves as the CPU fallback.
+//
+
+#include <cassert>
+#include <algorithm>
+
+#include "fftjet/FrequencyKernelConvolver.hh"
+
+template <typename Real, typename Complex>
+class FFTJetBatchConvolver :
+    public fftjet::FrequencyKernelConvolver<Real,Complex>
+{
+public:
+    typedef fftjet::FrequencyKernelConvolver<Real,Complex> Base;
+
+    inline FFTJetBatchConvolver(
+        const fftjet::AbsFFTEngine<Real,Complex>* fftBuilder,
+        const fftjet::AbsFrequencyKernel* kernel)
+        : Base(fftBuilder, kernel), precomputed_(0) {}
+
+    inline virtual ~FFTJetBatchConvolver() {}
+
+    // Use the given convolution result (not copied, must contain
+    // nEta*nPhi numbers) for the next event instead of calculating
+    // it. Call with NULL argument to return to normal operation.
+    inline void setPrecomputed(const Real* result) {precomputed_ = result;}
+
+    inline virtual void setEventData(const Real* data, const unsigned nEta,
+                                     const unsigned nPhi) override
+    {
+        // With a precomputed result, the forward transform is not needed
+        if (!precomputed_)
+            Base::setEventData(data, nEta, nPhi);
+    }
+
+    inline virtual void convolveWithKernel(const double scale, Real* result,
+                                           const unsigned nEta,
+                                           const unsigned nPhi) override
+    {
+        if (precomputed_)
+        {
+            assert(result);
+            std::copy(precomputed_, precomputed_ + nEta*nPhi, result);
+        }
+        else
+            Base::convolveWithKernel(scale, result, nEta, nPhi);
+    }
+
+private:
+    FFTJetBatchConvolver();
+    FFTJetBatchConvolver(const FFTJetBatchConvolver&);
+    FFTJetBatchConvolver& operator=(const FFTJetBatchConvolver&);
+
+    const Real* precomputed_;
+};
+
+#endif // FFTJetBatchConvolver_h_
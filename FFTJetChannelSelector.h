@@ -6,6 +6,10 @@
 #include "AbsChannelSelector.h"
 #include "HBHEChannelGeometry.h"
 #include "fftjetTypedefs.h"
+#include "FFTJetResultCache.h"
+#include "TaskPool.h"
+#include "AbsFFTJetBatchBackend.h"
+#include "FFTJetBatchConvolver.h"
 
 #include "fftjet/Grid2d.hh"
 #include "fftjet/Kernels.hh"
@@ -16,44 +20,206 @@
 #include "fftjet/PeakSelectors.hh"
 #include "fftjet/GaussianNoiseMembershipFcn.hh"
 
+//
+// Interface to jet information produced by FFTJet-based channel
+// selectors. It does not depend on the precision used for the
+// pattern recognition.
+//
 template <class AnalysisClass>
-class FFTJetChannelSelector : public AbsChannelSelector<AnalysisClass>
+class AbsFFTJetChannelSelector : public AbsChannelSelector<AnalysisClass>
 {
 public:
     typedef fftjet::RecombinedJet<VectorLike> Jet;
 
+    inline virtual ~AbsFFTJetChannelSelector() {}
+
+    // Jets reconstructed in the last event, in the order
+    // of decreasing Pt
+    virtual const std::vector<Jet>& getJets() const = 0;
+
+    virtual unsigned nGoodJets() const = 0;
+    virtual double getJetPt(unsigned i) const = 0;
+    virtual double getJetEta(unsigned i) const = 0;
+    virtual double getJetPhi(unsigned i) const = 0;
+
+    virtual const VectorLike& unclusteredP4() const = 0;
+    virtual double sumEt() const = 0;
+    virtual double unusedEt() const = 0;
+
+    // Run the channel association and the Et fraction cut in parallel,
+    // using the given pool (not owned), for events with at least
+    // "minPulses" pulses. NULL pool switches the parallelism off.
+    // The results do not depend on the parallelism.
+    virtual void setTaskPool(TaskPool* pool, unsigned minPulses) = 0;
+
+    // The jets must be reconstructed in every event
+    inline virtual bool hasEventResults() const {return true;}
+};
+
+//
+// Channel selector based on FFTJet jet reconstruction. The "Real"
+// template parameter defines the precision of the energy flow grid
+// and of the DFFT calculations used for pattern recognition (double
+// or float). The jet 4-vectors and the subsequent channel selection
+// are always calculated in double precision.
+//
+template <class AnalysisClass, typename Real = ::Real>
+class FFTJetChannelSelector : public AbsFFTJetChannelSelector<AnalysisClass>
+{
+public:
+    typedef fftjet::RecombinedJet<VectorLike> Jet;
+    typedef Real real_type;
+
     FFTJetChannelSelector(const HBHEChannelGeometry& geometry,
                           unsigned nEtaBins, double etaMin, double etaMax,
                           unsigned nPhiBins, double pattRecoScale,
                           double etaToPhiBandwidthRatio, double coneSize,
                           double peakEtCutoff, double jetPtCutoff,
-                          double channelEtFractionCutoff);
+                          double channelEtFractionCutoff,
+                          unsigned fftwPlannerFlags = FFTW_ESTIMATE);
 
-    inline virtual ~FFTJetChannelSelector() {}
+    inline virtual ~FFTJetChannelSelector() {delete batchBackend_;}
 
     virtual void select(const AnalysisClass& event,
                         std::vector<unsigned char>* mask,
                         std::vector<double>* associatedJetPt);
 
-    inline const std::vector<Jet>& getJets() const {return recoJets_;}
+    // In selector chains, the jets are still reconstructed from all
+    // channels, but only the listed channels are associated with the
+    // jets. The Et fraction cutoff is then applied to the Et of the
+    // listed channels of each jet.
+    virtual void selectFrom(const AnalysisClass& event,
+                            ChannelList* channels,
+                            std::vector<double>* associatedJetPt);
 
-    inline unsigned nGoodJets() const {return jetPt_.size();}
-    inline double getJetPt(const unsigned i) const {return jetPt_.at(i);}
-    inline double getJetEta(const unsigned i) const {return jetEta_.at(i);}
-    inline double getJetPhi(const unsigned i) const {return jetPhi_.at(i);}
+    inline virtual const std::vector<Jet>& getJets() const {return recoJets_;}
 
-    inline const VectorLike& unclusteredP4() const {return unclustered_;}
-    inline double sumEt() const {return sumEt_;}
-    inline double unusedEt() const {return unclusScalar_;}
+    inline virtual unsigned nGoodJets() const {return jetPt_.size();}
+    inline virtual double getJetPt(const unsigned i) const {return jetPt_.at(i);}
+    inline virtual double getJetEta(const unsigned i) const {return jetEta_.at(i);}
+    inline virtual double getJetPhi(const unsigned i) const {return jetPhi_.at(i);}
+
+    inline virtual const VectorLike& unclusteredP4() const {return unclustered_;}
+    inline virtual double sumEt() const {return sumEt_;}
+    inline virtual double unusedEt() const {return unclusScalar_;}
+
+    // Instead of running the jet reconstruction, take the jets from
+    // another selector which differs from this one only by the jet Pt
+    // and the Et fraction cutoffs. The "select" method of the source
+    // must be called for each event before the "select" method of this
+    // object. The source must not share jets itself. Call this method
+    // with NULL argument to restore normal operation.
+    void shareJetsWith(const FFTJetChannelSelector* source);
+
+    // Look up the jets in the given cache (not owned) before running
+    // the jet reconstruction, and store the newly reconstructed jets
+    // there. "configHash" must identify the jet reconstruction
+    // parameters of this selector (see FFTJetResultCache.h). The
+    // AnalysisClass must then provide "RunNumber" and "EventNumber".
+    // Jets taken from another selector (see "shareJetsWith") are not
+    // looked up. Call this method with NULL cache to stop using it.
+    void setResultCache(FFTJetResultCache* cache, uint64_t configHash);
+
+    virtual void setTaskPool(TaskPool* pool, unsigned minPulses);
+
+    // Convolve the energy flow grids with the given backend (which
+    // becomes owned by this object) for batches of events. Selectors
+    // which take the jets from another selector are not batched.
+    // Call with NULL argument to return to the CPU convolutions.
+    void setBatchBackend(AbsFFTJetBatchBackend<Real>* backend);
+
+    // Result of the convolution of a grid with unit content in the
+    // bin (0, 0) and zeros elsewhere, made by the CPU convolver.
+    // This defines the kernel for the batch backends.
+    void convolutionImpulseResponse(std::vector<Real>* response);
+
+    inline bool isBatched() const {return batchBackend_ && !jetSource_;}
+
+    // The energy flow grid, the jet index, the jet-channel buffers,
+    // and the batch grids
+    virtual std::size_t scratchBytes() const;
+
+    // With a batch backend, the energy flow grids of the batch events
+    // are filled by "addToBatch" and submitted for convolution by
+    // "submitBatch". The results are used when "select" or "selectFrom"
+    // is called for these events later, in the same order (the events
+    // are matched by their run and event numbers). Up to "maxBatch()"
+    // events of the backend are convolved together, the rest are
+    // processed on the CPU.
+    virtual void addToBatch(const AnalysisClass& event);
+    virtual void submitBatch();
 
 private:
     FFTJetChannelSelector();
 
+    // Fill the energy flow grid and run the jet reconstruction
+    void reconstructJets(const AnalysisClass& event);
+
+    // Calculate the channel Et and the total Et
+    void calculateChannelEt(const AnalysisClass& event);
+
+    // Fill the energy flow grid from the channel Et calculated earlier
+    void fillGrid(const AnalysisClass& event);
+
+    // Run the pattern recognition on the channel Et calculated earlier
+    void runPatternRecognition(const AnalysisClass& event);
+
+    // Convolution made for this event by the batch backend (NULL
+    // if there is none), waiting for the batch results if necessary
+    const Real* batchResult(const AnalysisClass& event);
+
+    // Fill the jet Pt, eta, and phi arrays
+    void fillJetKinematics();
+
+    // Reconstruct the jets or take them from the jet source
+    void findJets(const AnalysisClass& event);
+
+    // Associate the given pulses (all pulses from 0 to nChannels-1
+    // if "channels" is NULL) with the jets and mark the selected ones
+    void associateChannels(const AnalysisClass& event,
+                           const unsigned* channels, unsigned nChannels,
+                           std::vector<unsigned char>* mask,
+                           std::vector<double>* parentPt);
+
+    // Find the jets associated with the pulses from "channels[kFrom]"
+    // to "channels[kTo - 1]" (or from "kFrom" to "kTo - 1" if "channels"
+    // is NULL) and record them in "channelJet_". The jet index must be
+    // built already. Different ranges can be processed in parallel.
+    void associateRange(const AnalysisClass& event, const unsigned* channels,
+                        unsigned kFrom, unsigned kTo);
+
+    // Check whether the event is large enough to be processed in parallel
+    inline bool isParallel(const AnalysisClass& event) const
+    {
+        return taskPool_ && taskPool_->concurrency() > 1U &&
+            static_cast<unsigned>(event.PulseCount) >= parallelThreshold_;
+    }
+
+    // Maximum number of cells in eta and in phi
+    // for the jet lookup index
+    enum {MaxIndexCells = 64U};
+
+    // Build the eta-phi cell index for the current set of jets
+    void buildJetIndex(const double* jetEta, const double* jetPhi,
+                       unsigned nJets);
+
+    // Select the channels which survive the Et fraction cutoff
+    // among the channels associated with a jet. The "pairs" array
+    // (Et and pulse number) will be partially reordered.
+    void markEtFraction(std::pair<double,int>* pairs, unsigned long sz,
+                        double jetPt, std::vector<unsigned char>* mask,
+                        std::vector<double>* parentPt) const;
+
+    // Cell numbers for the jet index
+    unsigned indexPhiCell(double phi) const;
+    unsigned indexEtaCell(double eta) const;
+
     // Calorimeter geometry
     const HBHEChannelGeometry& geometry_;
 
     // Parameters specified in the constructor
     double patRecoScale_;
+    double peakEtCutoff_;
     double jetPtCutoff_;
 
     // Cone sizes in eta and phi
@@ -66,14 +232,21 @@ private:
     // Energy flow discretization grid
     fftjet::Grid2d<Real> calo_;
 
+    // Grid bins for each channel, indexed by the linear channel
+    // number. Negative eta bin means that the channel is outside
+    // of the grid eta range.
+    std::vector<int> channelEtaBin_;
+    std::vector<unsigned> channelPhiBin_;
+
     // The DFFT engine
-    MyFFTEngine engine_;
+    typename FFTJetPrecision<Real>::Engine engine_;
 
     // Pattern recognition convolution kernel
     fftjet::DiscreteGauss2d kernel_;
 
     // Convolver for the kernel
-    fftjet::FrequencyKernelConvolver<Real,Complex> convolver_;
+    FFTJetBatchConvolver<Real,
+        typename FFTJetPrecision<Real>::Complex> convolver_;
 
     // Peak finder
     fftjet::PeakFinder peakFinder_;
@@ -92,8 +265,35 @@ private:
     // The vector of reconstructed jets (we will refill it in every event)
     std::vector<Jet> recoJets_;
 
-    // Mapping from jets to channels
-    std::vector<std::vector<std::pair<double,int> > > jetChannels_;
+    // Eta-phi cell index of the jets. The cells are at least as large
+    // as the jet cone, so all jets within the cone of a channel can be
+    // found in the cell of that channel and in the neighboring cells.
+    // The jet numbers in cell k are stored in "cellJets_" between
+    // positions "cellStart_[k]" (included) and "cellStart_[k+1]"
+    // (excluded), in the increasing order.
+    double cellEtaMin_;
+    double cellEtaWidth_;
+    double cellPhiWidth_;
+    unsigned nEtaCells_;
+    unsigned nPhiCells_;
+    std::vector<unsigned> jetCell_;
+    std::vector<unsigned> cellStart_;
+    std::vector<unsigned> cellJets_;
+
+    // Jet number associated with each channel (or -1)
+    std::vector<int> channelJet_;
+
+    // Mask used by "selectFrom"
+    std::vector<unsigned char> subsetMask_;
+
+    // Mapping from jets to channels, stored in one buffer. The
+    // channels of jet k occupy the positions from jetChannelStart_[k]
+    // (included) to jetChannelStart_[k+1] (excluded).
+    std::vector<std::pair<double,int> > jetChannels_;
+    std::vector<unsigned> jetChannelStart_;
+
+    // Work space for filling the jet index and the jet channel buffer
+    std::vector<unsigned> fillPosition_;
 
     // Jet pt, eta and phi for fast access
     std::vector<double> jetPt_;
@@ -109,6 +309,28 @@ private:
 
     // Total visible transverse energy, summed as scalar
     double sumEt_;
+
+    // Selector whose jets we are using (not owned)
+    const FFTJetChannelSelector* jetSource_;
+
+    // Cache of the jet reconstruction results (not owned)
+    FFTJetResultCache* resultCache_;
+    uint64_t configHash_;
+
+    // Pool for the intra-event parallelism (not owned)
+    TaskPool* taskPool_;
+    unsigned parallelThreshold_;
+
+    // Batched convolutions. The grids of the batch being collected
+    // (or the results of the submitted batch) are stored one after
+    // another, for the events listed by run and event numbers.
+    AbsFFTJetBatchBackend<Real>* batchBackend_;
+    std::vector<Real> batchGrids_;
+    std::vector<Real> batchResults_;
+    std::vector<std::pair<long long,long long> > batchEvents_;
+    unsigned batchNext_;
+    bool batchOpen_;
+    bool batchPending_;
 };
 
 #include "FFTJetChannelSelector.icc"
@@ -0,0 +1,259 @@
+#include <cstring>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+#include <cuda_runtime.h>
+#include <cufft.h>
+
+#include "FFTJetCudaBackend.h"
+
+namespace {
+    template <typename Real>
+    struct CufftTraits;
+
+    template <>
+    struct CufftTraits<float>
+    {
+        typedef cufftComplex Complex;
+        static const cufftType forward = CUFFT_R2C;
+        static const cufftType backward = CUFFT_C2R;
+
+        static inline cufftResult execForward(cufftHandle plan, float* in,
+                                              Complex* out)
+            {return cufftExecR2C(plan, in, out);}
+        static inline cufftResult execBackward(cufftHandle plan, Complex* in,
+                                               float* out)
+            {return cufftExecC2R(plan, in, out);}
+    };
+
+    template <>
+    struct CufftTraits<double>
+    {
+        typedef cufftDoubleComplex Complex;
+        static const cufftType forward = CUFFT_D2Z;
+        static const cufftType backward = CUFFT_Z2D;
+
+        static inline cufftResult execForward(cufftHandle plan, double* in,
+                                              Complex* out)
+            {return cufftExecD2Z(plan, in, out);}
+        static inline cufftResult execBackward(cufftHandle plan, Complex* in,
+                                               double* out)
+            {return cufftExecZ2D(plan, in, out);}
+    };
+
+    void checkCuda(const cudaError_t err, const char* where)
+    {
+        if (err != cudaSuccess)
+        {
+            std::ostringstream os;
+            os << "In FFTJetCudaBackend::" << where << ": "
+               << cudaGetErrorString(err);
+            throw std::runtime_error(os.str());
+        }
+    }
+
+    void checkCufft(const cufftResult res, const char* where)
+    {
+        if (res != CUFFT_SUCCESS)
+        {
+            std::ostringstream os;
+            os << "In FFTJetCudaBackend::" << where << ": cuFFT error "
+               << static_cast<int>(res);
+            throw std::runtime_error(os.str());
+        }
+    }
+
+    // Multiply the spectra of all grids by the kernel spectrum.
+    // The normalization makes the inverse transform an inverse.
+    template <typename Complex, typename Real>
+    __global__ void multiplySpectra(Complex* spectra, const Complex* kernel,
+                                    const unsigned nPerGrid,
+                                    const unsigned nTotal, const Real norm)
+    {
+        const unsigned i = blockIdx.x*blockDim.x + threadIdx.x;
+        if (i < nTotal)
+        {
+            const Complex k = kernel[i % nPerGrid];
+            const Complex d = spectra[i];
+            Complex r;
+            r.x = (d.x*k.x - d.y*k.y)*norm;
+            r.y = (d.x*k.y + d.y*k.x)*norm;
+            spectra[i] = r;
+        }
+    }
+}
+
+template <typename Real>
+struct FFTJetCudaBackend<Real>::Impl
+{
+    typedef typename CufftTraits<Real>::Complex Complex;
+
+    inline Impl()
+        : stream(0), forward(0), backward(0),
+          hasStream(false), hasForward(false), hasBackward(false),
+          hostIn(0), hostOut(0), deviceGrids(0),
+          deviceSpectra(0), deviceKernel(0) {}
+
+    inline ~Impl()
+    {
+        if (hasForward)
+            cufftDestroy(forward);
+        if (hasBackward)
+            cufftDestroy(backward);
+        cudaFree(deviceKernel);
+        cudaFree(deviceSpectra);
+        cudaFree(deviceGrids);
+        cudaFreeHost(hostOut);
+        cudaFreeHost(hostIn);
+        if (hasStream)
+            cudaStreamDestroy(stream);
+    }
+
+    cudaStream_t stream;
+    cufftHandle forward;
+    cufftHandle backward;
+    bool hasStream;
+    bool hasForward;
+    bool hasBackward;
+
+    // Pinned host buffers, so that the copies are asynchronous
+    Real* hostIn;
+    Real* hostOut;
+
+    Real* deviceGrids;
+    Complex* deviceSpectra;
+    Complex* deviceKernel;
+};
+
+template <typename Real>
+FFTJetCudaBackend<Real>::FFTJetCudaBackend(const unsigned nEta,
+                                           const unsigned nPhi,
+                                           const unsigned maxBatch,
+                                           const Real* impulseResponse)
+    : nEta_(nEta), nPhi_(nPhi), maxBatch_(maxBatch),
+      nInFlight_(0), impl_(new Impl())
+{
+    typedef CufftTraits<Real> Traits;
+    typedef typename Traits::Complex Complex;
+
+    assert(nEta && nPhi && maxBatch);
+    assert(impulseResponse);
+    const unsigned long nReal = nEta*nPhi;
+    const unsigned long nSpec = nEta*(nPhi/2U + 1U);
+    const char* where = "FFTJetCudaBackend";
+
+    try
+    {
+        Impl& d(*impl_);
+        checkCuda(cudaStreamCreate(&d.stream), where);
+        d.hasStream = true;
+        checkCuda(cudaMallocHost(reinterpret_cast<void**>(&d.hostIn),
+                                 maxBatch*nReal*sizeof(Real)), where);
+        checkCuda(cudaMallocHost(reinterpret_cast<void**>(&d.hostOut),
+                                 maxBatch*nReal*sizeof(Real)), where);
+        checkCuda(cudaMalloc(reinterpret_cast<void**>(&d.deviceGrids),
+                             maxBatch*nReal*sizeof(Real)), where);
+        checkCuda(cudaMalloc(reinterpret_cast<void**>(&d.deviceSpectra),
+                             maxBatch*nSpec*sizeof(Complex)), where);
+        checkCuda(cudaMalloc(reinterpret_cast<void**>(&d.deviceKernel),
+                             nSpec*sizeof(Complex)), where);
+        checkCuda(cudaMemset(d.deviceGrids, 0, maxBatch*nReal*sizeof(Real)),
+                  where);
+
+        // The plans always transform the whole batch. Shorter batches
+        // (at the end of the input) just waste a bit of device time.
+        int dims[2] = {static_cast<int>(nEta), static_cast<int>(nPhi)};
+        checkCufft(cufftPlanMany(&d.forward, 2, dims, 0, 1, 0, 0, 1, 0,
+                                 Traits::forward, maxBatch), where);
+        d.hasForward = true;
+        checkCufft(cufftPlanMany(&d.backward, 2, dims, 0, 1, 0, 0, 1, 0,
+                                 Traits::backward, maxBatch), where);
+        d.hasBackward = true;
+        checkCufft(cufftSetStream(d.forward, d.stream), where);
+        checkCufft(cufftSetStream(d.backward, d.stream), where);
+
+        // Fourier image of the kernel
+        cufftHandle single;
+        checkCufft(cufftPlan2d(&single, nEta, nPhi, Traits::forward), where);
+        checkCuda(cudaMemcpy(d.deviceGrids, impulseResponse,
+                             nReal*sizeof(Real), cudaMemcpyHostToDevice),
+                  where);
+        const cufftResult res = Traits::execForward(
+            single, d.deviceGrids, d.deviceKernel);
+        cufftDestroy(single);
+        checkCufft(res, where);
+        checkCuda(cudaDeviceSynchronize(), where);
+    }
+    catch (...)
+    {
+        delete impl_;
+        throw;
+    }
+}
+
+template <typename Real>
+FFTJetCudaBackend<Real>::~FFTJetCudaBackend()
+{
+    if (nInFlight_)
+        cudaStreamSynchronize(impl_->stream);
+    delete impl_;
+}
+
+template <typename Real>
+void FFTJetCudaBackend<Real>::submit(const Real* grids, const unsigned nGrids)
+{
+    typedef CufftTraits<Real> Traits;
+
+    const char* where = "submit";
+    if (nInFlight_)
+        throw std::runtime_error("In FFTJetCudaBackend::submit: "
+                                 "previous batch was not retrieved");
+    assert(grids);
+    assert(nGrids && nGrids <= maxBatch_);
+
+    Impl& d(*impl_);
+    const unsigned long nReal = nEta_*nPhi_;
+    const unsigned nSpec = nEta_*(nPhi_/2U + 1U);
+    const unsigned long nBytes = nGrids*nReal*sizeof(Real);
+    std::memcpy(d.hostIn, grids, nBytes);
+    checkCuda(cudaMemcpyAsync(d.deviceGrids, d.hostIn, nBytes,
+                              cudaMemcpyHostToDevice, d.stream), where);
+    checkCufft(Traits::execForward(d.forward, d.deviceGrids,
+                                   d.deviceSpectra), where);
+    const unsigned nTotal = nGrids*nSpec;
+    const unsigned blockSize = 256U;
+    multiplySpectra<<<(nTotal + blockSize - 1U)/blockSize,
+        blockSize, 0, d.stream>>>(d.deviceSpectra, d.deviceKernel,
+                                  nSpec, nTotal,
+                                  static_cast<Real>(1.0/nReal));
+    checkCuda(cudaGetLastError(), where);
+    checkCufft(Traits::execBackward(d.backward, d.deviceSpectra,
+                                    d.deviceGrids), where);
+    checkCuda(cudaMemcpyAsync(d.hostOut, d.deviceGrids, nBytes,
+                              cudaMemcpyDeviceToHost, d.stream), where);
+    nInFlight_ = nGrids;
+}
+
+template <typename Real>
+void FFTJetCudaBackend<Real>::retrieve(Real* results)
+{
+    if (!nInFlight_)
+        throw std::runtime_error("In FFTJetCudaBackend::retrieve: "
+                                 "no batch was submitted");
+    assert(results);
+    checkCuda(cudaStreamSynchronize(impl_->stream), "retrieve");
+    std::memcpy(results, impl_->hostOut,
+                nInFlight_*static_cast<unsigned long>(nEta_*nPhi_)*sizeof(Real));
+    nInFlight_ = 0;
+}
+
+template <typename Real>
+bool FFTJetCudaBackend<Real>::available()
+{
+    int n = 0;
+    return cudaGetDeviceCount(&n) == cudaSuccess && n > 0;
+}
+
+template class FFTJetCudaBackend<float>;
+template class FFTJetCudaBackend<double>;
@@ -0,0 +1,62 @@
+#ifndef FFTJetCudaBackend_h_
+#define FFTJetCudaBackend_h_
+
+//
+// AbsFFTJetBatchBackend which convolves the energy flow grids on an
+// NVidia GPU with batched cuFFT plans. For every batch, the grids are
+// copied to the device, transformed, multiplied by the Fourier image
+// of the kernel, transformed back, and copied back to the host, all
+// on one CUDA stream, so that "submit" returns immediately.
+//
+// The kernel is defined by its impulse response: the convolution
+// (calculated by the CPU convolver) of a grid with unit content in
+// the bin (0, 0) and zeros everywhere else. This way the device
+// reproduces the CPU convolution, including its normalization and
+// bin conventions, up to the rounding errors.
+//
+// The implementation (FFTJetCudaBackend.cu) is compiled only by
+// "make cuda", which also defines USE_CUDA_FFTJET. This header
+// does not need the CUDA headers.
+//
+
+#include "AbsFFTJetBatchBackend.h"
+
+template <typename Real>
+class FFTJetCudaBackend : public AbsFFTJetBatchBackend<Real>
+{
+public:
+    // "impulseResponse" must have nEta*nPhi elements. Throws
+    // std::runtime_error if the device resources can not be allocated.
+    FFTJetCudaBackend(unsigned nEta, unsigned nPhi, unsigned maxBatch,
+                      const Real* impulseResponse);
+
+    virtual ~FFTJetCudaBackend();
+
+    inline virtual unsigned nEta() const override {return nEta_;}
+    inline virtual unsigned nPhi() const override {return nPhi_;}
+    inline virtual unsigned maxBatch() const override {return maxBatch_;}
+
+    virtual void submit(const Real* grids, unsigned nGrids) override;
+    virtual void retrieve(Real* results) override;
+
+    inline virtual const char* name() const override {return "CUDA";}
+
+    // Check whether a CUDA device is present
+    static bool available();
+
+private:
+    FFTJetCudaBackend();
+    FFTJetCudaBackend(const FFTJetCudaBackend&);
+    FFTJetCudaBackend& operator=(const FFTJetCudaBackend&);
+
+    // Device resources, defined in the .cu file
+    struct Impl;
+
+    unsigned nEta_;
+    unsigned nPhi_;
+    unsigned maxBatch_;
+    unsigned nInFlight_;
+    Impl* impl_;
+};
+
+#endif // FFTJetCudaBackend_h_
@@ -0,0 +1,171 @@
+#ifndef FFTJetResultCache_h_
+#define FFTJetResultCache_h_
+
+//
+// Persistent cache of FFTJet jet reconstruction results, kept in
+// a binary file next to the analysis outputs. For every event, the
+// file stores the reconstructed jets, the unclustered 4-vector, the
+// unclustered scalar Et, and the total Et, keyed by the run number,
+// the event number, and a hash of the selector configuration. The
+// results of several configurations can be kept in one file.
+//
+// FFTJetChannelSelector looks up the jets in the cache instead of
+// running the pattern recognition (see its "setResultCache" method).
+// Only the jet reconstruction is cached: the association of channels
+// with jets is cheap and is always redone, so that the jet Pt and the
+// Et fraction cutoffs (and the channels seen by the selector in
+// selector chains) can be changed without invalidating the cache.
+//
+// The results added by "store" are kept in memory until "flush" is
+// called, and then they are appended to the file. In the multithreaded
+// mode, every worker should have its own cache object made from the
+// same file. Only the first worker should flush, after collecting
+// the new results of the other workers with "merge". All cache
+// objects have to be made before any of them is flushed.
+//
+// The configuration hash should be calculated with "hashString" from
+// a string which describes everything the jet reconstruction depends
+// upon: the energy definition, the geometry, the grid, the FFTJet
+// parameters, and the precision.
+//
+// The binary format uses the native byte order and is not meant to be
+// moved between machines of different architectures (this is detected,
+// and such files are rejected).
+//
+
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "fftjetTypedefs.h"
+#include "fftjet/RecombinedJet.hh"
+
+class FFTJetResultCache
+{
+public:
+    typedef fftjet::RecombinedJet<VectorLike> Jet;
+
+    // The existing cache file is read in the constructor. If the file
+    // does not exist, it will be created by the first "flush". Throws
+    // std::runtime_error if the file exists but is not a valid cache.
+    explicit FFTJetResultCache(const std::string& filename);
+
+    inline ~FFTJetResultCache() {}
+
+    inline const std::string& filename() const {return filename_;}
+
+    // Look up the results for the given configuration and event.
+    // Returns "false" if the results are not in the cache.
+    bool lookup(uint64_t configHash, long long run, long long event,
+                std::vector<Jet>* jets, VectorLike* unclustered,
+                double* unclusScalar, double* sumEt);
+
+    // Add the results (ignored if they are already in the cache)
+    void store(uint64_t configHash, long long run, long long event,
+               const std::vector<Jet>& jets, const VectorLike& unclustered,
+               double unclusScalar, double sumEt);
+
+    // Add the results stored by "other" (with the same file name)
+    // since its last flush. These results are then no longer
+    // considered new by "other". The lookup statistics of "other"
+    // are moved to this object as well.
+    void merge(FFTJetResultCache& other);
+
+    // Append the new results to the file. Throws std::runtime_error
+    // if the file can not be written.
+    void flush();
+
+    // Number of results read from the file and added by "store"
+    inline unsigned long size() const {return entries_.size();}
+
+    // Number of results not yet written to the file
+    inline unsigned long nPending() const {return entries_.size() - nFlushed_;}
+
+    // Lookup statistics
+    inline unsigned long nHits() const {return nHits_;}
+    inline unsigned long nMisses() const {return nMisses_;}
+
+    // FNV-1a hash of a configuration description
+    static uint64_t hashString(const std::string& description);
+
+private:
+    FFTJetResultCache();
+    FFTJetResultCache(const FFTJetResultCache&);
+    FFTJetResultCache& operator=(const FFTJetResultCache&);
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t jetRecordSize;
+        uint32_t reserved;
+    };
+
+    struct EventRecord
+    {
+        uint64_t configHash;
+        int64_t run;
+        int64_t event;
+        double sumEt;
+        double unclusScalar;
+        double unclustered[4];
+        uint32_t nJets;
+        uint32_t reserved;
+    };
+
+    struct JetRecord
+    {
+        double p4[4];
+        double peak[11];
+        double jet[12];
+        int32_t code;
+        int32_t status;
+    };
+
+    struct Key
+    {
+        inline Key(const uint64_t h, const int64_t r, const int64_t e)
+            : hash(h), run(r), event(e) {}
+
+        inline bool operator<(const Key& k) const
+        {
+            if (hash != k.hash) return hash < k.hash;
+            if (run != k.run) return run < k.run;
+            return event < k.event;
+        }
+
+        uint64_t hash;
+        int64_t run;
+        int64_t event;
+    };
+
+    struct Entry
+    {
+        EventRecord header;
+        unsigned firstJet;
+    };
+
+    static void packJet(const Jet& jet, JetRecord* r);
+    static Jet unpackJet(const JetRecord& r);
+
+    void read();
+    void addEntry(const EventRecord& header, const JetRecord* jets);
+
+    std::string filename_;
+    std::map<Key,unsigned> index_;
+    std::vector<Entry> entries_;
+    std::vector<JetRecord> jets_;
+
+    // Size of the valid part of the file and the number
+    // of entries which it contains
+    uint64_t fileSize_;
+    unsigned long nFlushed_;
+
+    unsigned long nHits_;
+    unsigned long nMisses_;
+};
+
+#endif // FFTJetResultCache_h_
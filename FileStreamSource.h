@@ -0,0 +1,192 @@
+#ifndef FileStreamSource_h_
+#define FileStreamSource_h_
+
+//
+// Source of input file names for the streaming mode of RootChainProcessor
+// (see "processStream"). The names are either read from the standard
+// input, one per line, or discovered in a directory which is watched
+// for new root files.
+//
+// In the directory mode, a file is reported once it has the ".root"
+// suffix, its name does not start with '.', and its size has not changed
+// between two consecutive polls. The files are reported in the order of
+// their names. Tools which copy files into the directory should either
+// write them under a temporary name starting with '.' and rename them
+// when done or rely on the size check.
+//
+// In the standard input mode, empty lines and lines starting with '#'
+// are ignored, and the stream ends when the standard input is closed.
+// The directory stream never ends by itself.
+//
+
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cassert>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <poll.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+class FileStreamSource
+{
+public:
+    // "spec" is the directory to watch or "-" for the standard input
+    inline explicit FileStreamSource(const std::string& spec)
+        : spec_(spec), useStdin_(spec == "-"), ended_(false)
+    {
+        if (spec_.empty())
+            throw std::invalid_argument("In FileStreamSource constructor: "
+                                        "empty stream specification");
+        if (!useStdin_)
+        {
+            struct stat st;
+            if (stat(spec_.c_str(), &st) || !S_ISDIR(st.st_mode))
+            {
+                std::ostringstream os;
+                os << "In FileStreamSource constructor: \"" << spec_
+                   << "\" is not a directory";
+                throw std::invalid_argument(os.str());
+            }
+        }
+    }
+
+    inline const std::string& spec() const {return spec_;}
+
+    // Append the names of the files which became available since the
+    // previous call. If nothing is available, wait for at most
+    // "maxWaitSeconds". Returns false when the stream has ended
+    // and there will be no more files.
+    inline bool poll(std::vector<std::string>* newFiles,
+                     const double maxWaitSeconds)
+    {
+        assert(newFiles);
+        if (ended_)
+            return false;
+        if (useStdin_)
+            return pollStdin(newFiles, maxWaitSeconds);
+        else
+        {
+            pollDirectory(newFiles);
+            if (newFiles->empty() && maxWaitSeconds > 0.0)
+            {
+                usleep(static_cast<useconds_t>(maxWaitSeconds*1.0e6));
+                pollDirectory(newFiles);
+            }
+            return true;
+        }
+    }
+
+    inline bool ended() const {return ended_;}
+
+private:
+    inline bool pollStdin(std::vector<std::string>* newFiles,
+                          const double maxWaitSeconds)
+    {
+        // The standard input is read with "read" rather than with
+        // std::cin, so that "poll" sees all unconsumed data
+        struct pollfd pfd;
+        pfd.fd = STDIN_FILENO;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const int timeout = maxWaitSeconds > 0.0 ?
+            static_cast<int>(maxWaitSeconds*1000.0) : 0;
+        const int ready = ::poll(&pfd, 1, timeout);
+        if (ready < 0 && errno != EINTR)
+            throw std::runtime_error("In FileStreamSource::poll: "
+                                     "failed to poll the standard input");
+        if (ready > 0)
+        {
+            char buf[4096];
+            const ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+            if (n > 0)
+                pending_.append(buf, n);
+            else if (n == 0)
+                ended_ = true;
+        }
+
+        std::size_t pos;
+        while ((pos = pending_.find('\n')) != std::string::npos)
+        {
+            addLine(pending_.substr(0, pos), newFiles);
+            pending_.erase(0, pos + 1U);
+        }
+        if (ended_)
+        {
+            addLine(pending_, newFiles);
+            pending_.clear();
+        }
+        return !ended_ || !newFiles->empty();
+    }
+
+    inline void addLine(const std::string& line,
+                        std::vector<std::string>* newFiles) const
+    {
+        const std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#')
+            return;
+        const std::size_t last = line.find_last_not_of(" \t\r");
+        newFiles->push_back(line.substr(first, last + 1U - first));
+    }
+
+    inline void pollDirectory(std::vector<std::string>* newFiles)
+    {
+        DIR* dir = opendir(spec_.c_str());
+        if (!dir)
+        {
+            std::ostringstream os;
+            os << "In FileStreamSource::poll: failed to open directory \""
+               << spec_ << '"';
+            throw std::runtime_error(os.str());
+        }
+        std::vector<std::string> names;
+        while (struct dirent* e = readdir(dir))
+        {
+            const std::string name(e->d_name);
+            const std::size_t len = name.size();
+            if (len > 5U && name[0] != '.' &&
+                name.compare(len - 5U, 5U, ".root") == 0 &&
+                seen_.find(name) == seen_.end())
+                names.push_back(name);
+        }
+        closedir(dir);
+        std::sort(names.begin(), names.end());
+
+        // Report the files whose size did not change since the last poll
+        std::map<std::string,long long> sizes;
+        const unsigned nNames = names.size();
+        for (unsigned i=0; i<nNames; ++i)
+        {
+            const std::string path = spec_ + '/' + names[i];
+            struct stat st;
+            if (stat(path.c_str(), &st) || !S_ISREG(st.st_mode))
+                continue;
+            const long long size = st.st_size;
+            const std::map<std::string,long long>::const_iterator it =
+                lastSizes_.find(names[i]);
+            if (it != lastSizes_.end() && it->second == size && size > 0)
+            {
+                seen_.insert(names[i]);
+                newFiles->push_back(path);
+            }
+            else
+                sizes[names[i]] = size;
+        }
+        lastSizes_.swap(sizes);
+    }
+
+    std::string spec_;
+    bool useStdin_;
+    bool ended_;
+    std::string pending_;
+    std::set<std::string> seen_;
+    std::map<std::string,long long> lastSizes_;
+};
+
+#endif // FileStreamSource_h_
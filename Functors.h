@@ -134,6 +134,25 @@
 // And, Or, Not   yes    yes    Logical operations on other functors (usually,
 //                              for use as selectors).
 //
+// Memo           yes    yes    Caches the values of another functor, so
+//                              that an expensive quantity used by several
+//                              histograms or ntuple columns is calculated
+//                              only once per fill. The cache is shared by
+//                              all copies of the Memo object and it is
+//                              invalidated whenever the value of the
+//                              "generation" counter changes. Example:
+//                              Memo(Method(&A::get, this),
+//                                   manager_.fillGeneration()).
+//                              HistogramManager increments its fill
+//                              generation in every "AutoFill" and
+//                              "CycleFill" call, so the values are shared
+//                              between the items of one group. To share
+//                              them between groups (or with a
+//                              FusedCycledSet) filled for the same event,
+//                              use some event counter instead. In the
+//                              cycled mode, the values are cached for
+//                              every cycle number separately.
+//
 // Naturally, other functors can be developed in a similar manner whenever
 // additional functionality is needed.
 //
@@ -143,6 +162,9 @@
 
 #include <cassert>
 #include <vector>
+#include <memory>
+#include <utility>
+#include <type_traits>
 
 
 class Double
@@ -881,4 +903,87 @@ inline OrHlp<Functor1,Functor2> Or(const Functor1& f1, const Functor2& f2)
     return OrHlp<Functor1,Functor2>(f1, f2);
 }
 
+//======================================================================
+
+namespace Private {
+    // Type of the values returned by a functor, determined from
+    // "operator()(unsigned) const" if the functor has it and from
+    // "operator()() const" otherwise
+    template<class Functor>
+    struct MemoResult
+    {
+        template<class F>
+        static auto test(int) -> decltype(std::declval<const F&>()(0U));
+
+        template<class F>
+        static auto test(...) -> decltype(std::declval<const F&>()());
+
+        typedef typename std::decay<decltype(test<Functor>(0))>::type type;
+    };
+}
+
+template<class Functor, typename Counter>
+class MemoHlp
+{
+public:
+    typedef typename Private::MemoResult<Functor>::type Result;
+
+    inline MemoHlp(const Functor& f, const Counter& generation)
+        : f_(f), generation_(&generation), cache_(new Cache()) {}
+
+    inline Result operator()() const
+    {
+        // Cache stamps are generation + 1, so that 0 never matches
+        const Counter stamp = *generation_ + 1;
+        Cache& c(*cache_);
+        if (c.stamp != stamp)
+        {
+            c.value = f_();
+            c.stamp = stamp;
+        }
+        return c.value;
+    }
+
+    inline Result operator()(const unsigned i) const
+    {
+        const Counter stamp = *generation_ + 1;
+        Cache& c(*cache_);
+        if (i >= c.stamps.size())
+        {
+            c.stamps.resize(i + 1U, Counter());
+            c.values.resize(i + 1U);
+        }
+        if (c.stamps[i] != stamp)
+        {
+            c.values[i] = f_(i);
+            c.stamps[i] = stamp;
+        }
+        return c.values[i];
+    }
+
+private:
+    struct Cache
+    {
+        inline Cache() : value(), stamp() {}
+
+        Result value;
+        Counter stamp;
+        std::vector<Result> values;
+        std::vector<Counter> stamps;
+    };
+
+    MemoHlp();
+
+    Functor f_;
+    const Counter* generation_;
+    std::shared_ptr<Cache> cache_;
+};
+
+template<class Functor, typename Counter>
+inline MemoHlp<Functor,Counter> Memo(const Functor& f,
+                                     const Counter& generation)
+{
+    return MemoHlp<Functor,Counter>(f, generation);
+}
+
 #endif // Functors_h_
@@ -0,0 +1,118 @@
+#ifndef FusedCycledSet_h_
+#define FusedCycledSet_h_
+
+//
+// Compile-time set of cycled histograms, ntuples, and trees which are
+// filled together, in a single loop over cycles.
+//
+// ManagedHistoContainer fills its items one after another, and each
+// cycled item runs its own loop over cycles. For N items in a group,
+// the channel arrays used by the functors are then traversed N times.
+// FusedCycledSet instead calls, for every cycle i, the "FillCycle(i)"
+// method of every item, so that all functors are evaluated for channel
+// i together. The item types are known at compile time, so these calls
+// are not virtual and can be inlined.
+//
+// FusedCycledSet does not own its items. The items should still be
+// booked and managed by a HistogramManager (this takes care of their
+// directories, writing, merging, and deletion), but in a group which
+// is never filled by the manager itself. Null item pointers are allowed
+// and are skipped, so that items booked only on request can be included.
+//
+// Item types must implement the non-virtual methods "BeginCycles()",
+// "FillCycle(unsigned)", and "EndCycles()". This is done by CycledH1D,
+// CycledH2D, CycledH3D, CycledNtuple, CycledNtupleD, CycledTree, and
+// CycledArrayTree.
+//
+// Example:
+//
+//   // In the class declaration
+//   typedef CycledH1DHelper<ElementOfHlp<double>,Double> EHisto;
+//   typedef CycledH2DHelper<ElementOfHlp<Int_t>,ElementOfHlp<Int_t>,
+//                           ElementEQHlp<Int_t> > OccHisto;
+//   FusedCycledSet<EHisto,OccHisto> hbhe_;
+//
+//   // In "bookManagedHistograms"
+//   EHisto* h1 = CycledH1D(...);
+//   manager_.manage(h1, "HBHEFused");
+//   OccHisto* h2 = CycledH2D(...);
+//   manager_.manage(h2, "HBHEFused");
+//   hbhe_ = fuseCycled(h1, h2);
+//
+//   // In "fillManagedHistograms"
+//   hbhe_.CycleFill(this->PulseCount);
+//
+
+#include <tuple>
+
+namespace tupleutils
+{
+    template<typename Items, int N>
+    struct FusedCycler
+    {
+        inline static void begin(const Items& items)
+        {
+            FusedCycler<Items, N-1>::begin(items);
+            if (std::get<N-1>(items))
+                std::get<N-1>(items)->BeginCycles();
+        }
+
+        inline static void fill(const Items& items, const unsigned i)
+        {
+            FusedCycler<Items, N-1>::fill(items, i);
+            if (std::get<N-1>(items))
+                std::get<N-1>(items)->FillCycle(i);
+        }
+
+        inline static void end(const Items& items)
+        {
+            FusedCycler<Items, N-1>::end(items);
+            if (std::get<N-1>(items))
+                std::get<N-1>(items)->EndCycles();
+        }
+    };
+
+    template<typename Items>
+    struct FusedCycler<Items, 0>
+    {
+        inline static void begin(const Items&) {}
+        inline static void fill(const Items&, unsigned) {}
+        inline static void end(const Items&) {}
+    };
+}
+
+template<class... Items>
+class FusedCycledSet
+{
+public:
+    typedef std::tuple<Items*...> item_pointers;
+
+    // The default object contains null pointers only
+    inline FusedCycledSet() : items_() {}
+
+    inline explicit FusedCycledSet(Items*... items) : items_(items...) {}
+
+    inline const item_pointers& items() const {return items_;}
+
+    inline void CycleFill(const unsigned nCycles) const
+    {
+        Cycler::begin(items_);
+        for (unsigned i=0; i<nCycles; ++i)
+            Cycler::fill(items_, i);
+        Cycler::end(items_);
+    }
+
+private:
+    typedef tupleutils::FusedCycler<
+        item_pointers, std::tuple_size<item_pointers>::value> Cycler;
+
+    item_pointers items_;
+};
+
+template<class... Items>
+inline FusedCycledSet<Items...> fuseCycled(Items*... items)
+{
+    return FusedCycledSet<Items...>(items...);
+}
+
+#endif // FusedCycledSet_h_
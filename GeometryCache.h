@@ -0,0 +1,106 @@
+#ifndef GeometryCache_h_
+#define GeometryCache_h_
+
+//
+// Binary, memory-mapped version of the geometry text files found
+// in the "Geometry" directory ("hb.ctr", "eb.ctr", "es.ctr", etc).
+//
+// Each line of these text files contains a few integer keys (e.g.,
+// "ieta iphi depth" for HCAL or "ieta iphi" for the ECAL barrel)
+// followed by the x, y, and z coordinates of the cell center. The
+// binary file keeps, for every row of the text file (in the same
+// order), the keys and the precomputed unit direction, pseudorapidity,
+// azimuthal angle, and sine of the polar angle of the cell. The file
+// is mapped into memory by the GeometryCache constructor, so that the
+// data can be used without parsing and without copying. The row number
+// serves as the linear index of the cell.
+//
+// The binary files are made by the "convertGeometryToBinary" program
+// (or by calling GeometryCache::write). By convention, the binary file
+// for "name.ctr" is called "name.ctr.bin". The size and modification
+// time of the text file are recorded in the binary file, so that the
+// cache which no longer corresponds to its text file can be detected
+// with "isUsable" and ignored.
+//
+// The binary format uses the native byte order and is not meant to
+// be moved between machines of different architectures (this is
+// detected, and such files are rejected).
+//
+
+#include <string>
+#include <cassert>
+#include <stdint.h>
+
+class GeometryCache
+{
+public:
+    // Map the given binary file into memory. Throws std::runtime_error
+    // if the file can not be opened or is not a valid geometry cache.
+    explicit GeometryCache(const char* cacheFile);
+
+    ~GeometryCache();
+
+    inline unsigned nRows() const {return nRows_;}
+    inline unsigned nKeys() const {return nKeys_;}
+
+    // Integer key k of the given row
+    inline int key(const unsigned row, const unsigned k) const
+    {
+        assert(row < nRows_ && k < nKeys_);
+        return keys_[row*nKeys_ + k];
+    }
+
+    // Arrays of length "nRows()"
+    inline const double* x() const {return x_;}
+    inline const double* y() const {return x_ + nRows_;}
+    inline const double* z() const {return x_ + 2U*nRows_;}
+    inline const double* eta() const {return x_ + 3U*nRows_;}
+    inline const double* phi() const {return x_ + 4U*nRows_;}
+    inline const double* perp() const {return x_ + 5U*nRows_;}
+
+    // Conventional name of the binary file for the given text file
+    static std::string defaultName(const char* textFile);
+
+    // Check that the binary file exists and was made from the current
+    // version of the text file (if the text file exists)
+    static bool isUsable(const char* cacheFile, const char* textFile);
+
+    // Convert a text file into the binary format. If "nKeys" is
+    // negative, the number of keys is set to the number of columns
+    // minus 3. Throws std::invalid_argument if the text file can not
+    // be read or parsed and std::runtime_error if the output can not
+    // be written.
+    static void write(const char* textFile, const char* cacheFile,
+                      int nKeys = -1);
+
+private:
+    GeometryCache();
+    GeometryCache(const GeometryCache&);
+    GeometryCache& operator=(const GeometryCache&);
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t nRows;
+        uint32_t nKeys;
+        uint64_t sourceSize;
+        int64_t sourceMTime;
+        uint64_t dataOffset;
+        uint64_t reserved[2];
+    };
+
+    static bool readHeader(const char* cacheFile, Header* h);
+    static bool isValidHeader(const Header& h);
+    static uint64_t keysSize(uint32_t nRows, uint32_t nKeys);
+
+    void* map_;
+    std::size_t mapLength_;
+    unsigned nRows_;
+    unsigned nKeys_;
+    const int32_t* keys_;
+    const double* x_;
+};
+
+#endif // GeometryCache_h_
@@ -10,6 +10,18 @@
 // physical direction of the tower can be then looked up by channel number
 // using the "getDirection" method.
 //
+// Pseudorapidity, azimuthal angle, and sine of the polar angle of each
+// channel direction are precomputed as well. They are stored in contiguous
+// arrays indexed by the linear channel number (see HBHEChannelMap) which
+// can be accessed directly with "etaData", "phiData", and "perpData".
+// These arrays have HBHEChannelMap::ChannelCount elements each.
+//
+// If the binary version of a geometry file ("hb.ctr.bin" for "hb.ctr",
+// see GeometryCache.h) exists and is up to date, it is used instead of
+// the text file. The angular variables are then taken from the cache
+// as well. The results are identical, but nothing is parsed or
+// recomputed.
+//
 // I. Volobouev
 // April 2013
 //
@@ -28,10 +40,26 @@ public:
     inline const TVector3& getDirection(const unsigned channel) const
          {return directions_.at(channel);}
 
+    inline double getEta(const unsigned channel) const
+         {return eta_.at(channel);}
+    inline double getPhi(const unsigned channel) const
+         {return phi_.at(channel);}
+    inline double getPerp(const unsigned channel) const
+         {return perp_.at(channel);}
+
+    // Direct access to the precomputed arrays (no bounds checking)
+    inline const double* etaData() const {return &eta_[0];}
+    inline const double* phiData() const {return &phi_[0];}
+    inline const double* perpData() const {return &perp_[0];}
+
 private:
     void loadData(const char* filename, const HBHEChannelMap& chmap);
+    void setDirection(unsigned idx, const TVector3& dir);
 
     std::vector<TVector3> directions_;
+    std::vector<double> eta_;
+    std::vector<double> phi_;
+    std::vector<double> perp_;
 };
 
 #endif // HBHEChannelGeometry_h_
@@ -14,8 +14,8 @@
 // September 2014
 //
 
-#include <map>
 #include <vector>
+#include <stdexcept>
 
 #include "HcalSubdetector.h"
 #include "HcalHPDRBXMap.h"
@@ -25,6 +25,14 @@ class HBHEChannelMap
 public:
     enum {ChannelCount = 5184U};
 
+    // Ranges of the depth/ieta/iphi variables covered by
+    // the internal lookup table
+    enum {
+        MaxDepth = 3,
+        MaxAbsIEta = 29,
+        MaxIPhi = 72
+    };
+
     HBHEChannelMap();
 
     // Mapping from the depth/ieta/iphi triple which uniquely
@@ -32,10 +40,26 @@ public:
     // from 0 to 5183 (inclusive). This linear index should not
     // be treated as anything meaningful -- consider it to be
     // just a convenient unique key in a database table.
-    unsigned linearIndex(unsigned depth, int ieta, unsigned iphi) const;
+    inline unsigned linearIndex(const unsigned depth, const int ieta,
+                                const unsigned iphi) const
+    {
+        const unsigned idx = lookupIndex(depth, ieta, iphi);
+        if (idx == InvalidIndex)
+            throw std::invalid_argument("In HBHEChannelMap::linearIndex: "
+                                        "invalid channel triple");
+        return idx;
+    }
+
+    // Same mapping for arrays of depth/ieta/iphi values (for example,
+    // for all pulses in an event). The results are placed into the
+    // "out" array which must have at least "n" elements.
+    void linearIndices(const int* depth, const int* ieta, const int* iphi,
+                       unsigned n, unsigned* out) const;
 
     // Check whether the given triple is a valid depth/ieta/iphi combination
-    bool isValidTriple(unsigned depth, int ieta, unsigned iphi) const;
+    inline bool isValidTriple(const unsigned depth, const int ieta,
+                              const unsigned iphi) const
+        {return lookupIndex(depth, ieta, iphi) != InvalidIndex;}
 
     // Inverse mapping, from a linear index into depth/ieta/iphi triple.
     // Any of the argument pointers is allowed to be NULL in which case
@@ -53,26 +77,83 @@ public:
     unsigned getRBX(unsigned channelNumber) const;
     unsigned getChannelInRBX(unsigned channelNumber) const;
 
+    // Read-only view of a contiguous array of linear channel indices.
+    // The channel, HPD, and RBX relations are stored in the compressed
+    // sparse row format: one offset table and one index table per
+    // relation, all filled in the constructor. The index ranges
+    // returned by the lookup methods below point into these tables
+    // and remain valid for the lifetime of the HBHEChannelMap object.
+    class IndexRange
+    {
+    public:
+        inline IndexRange(const unsigned* first, const unsigned* last)
+            : begin_(first), end_(last) {}
+
+        inline const unsigned* begin() const {return begin_;}
+        inline const unsigned* end() const {return end_;}
+        inline unsigned size() const {return end_ - begin_;}
+        inline bool empty() const {return begin_ == end_;}
+        inline unsigned operator[](const unsigned i) const {return begin_[i];}
+
+        inline std::vector<unsigned> toVector() const
+            {return std::vector<unsigned>(begin_, end_);}
+
+    private:
+        const unsigned* begin_;
+        const unsigned* end_;
+    };
+
     // Lookup the list of channels geometrically neighboring the given
-    // channel but coming from other HPDs
-    const std::vector<unsigned>& channelNeigborsFromOtherHPDs(
-        unsigned channelNumber) const;
+    // channel but coming from other HPDs. The list is sorted.
+    inline IndexRange channelNeigborsFromOtherHPDs(
+        const unsigned channelNumber) const
+    {
+        if (channelNumber >= ChannelCount)
+            throw std::out_of_range("In HBHEChannelMap::channelNeigborsFrom"
+                                    "OtherHPDs: input index out of range");
+        return csrRange(channel_neighbor_offsets_, &channel_neighbors_[0],
+                        channelNumber);
+    }
 
     // Fill unique neighbors for the given set of channels. This method
-    // assumes that all input channels come from a single HPD.
+    // is optimized for input channels coming from a single HPD (larger
+    // inputs are passed to the general version below).
     void channelSetNeighbors(const std::vector<unsigned>& input,
                              std::vector<unsigned>* output) const;
 
+    // Fill unique neighbors from other HPDs for an arbitrary number
+    // of channels (which do not have to come from the same HPD). The
+    // output is sorted. Channels present in the input can appear
+    // in the output if they come from different HPDs.
+    void channelSetNeighbors(const unsigned* input, unsigned nInput,
+                             std::vector<unsigned>* output) const;
+
     // Look up linear channel indices for a given HPD
-    inline const std::vector<unsigned>& getHPDChannels(unsigned hpd) const
-        {return hpd_channel_lookup_.at(hpd);}
+    inline IndexRange getHPDChannels(const unsigned hpd) const
+    {
+        if (hpd >= static_cast<unsigned>(HcalHPDRBXMap::NUM_HPDS))
+            throw std::out_of_range("In HBHEChannelMap::getHPDChannels: "
+                                    "input index out of range");
+        return csrRange(hpd_channel_offsets_, hpd_channels_, hpd);
+    }
 
     // Look up linear channel indices for all neighbors of a given HPD
-    const std::vector<unsigned>& getHPDNeigbors(unsigned hpd) const;
+    inline IndexRange getHPDNeigbors(const unsigned hpd) const
+    {
+        if (hpd >= static_cast<unsigned>(HcalHPDRBXMap::NUM_HPDS))
+            throw std::out_of_range("In HBHEChannelMap::getHPDNeigbors: "
+                                    "input index out of range");
+        return csrRange(hpd_neighbor_offsets_, &hpd_neighbors_[0], hpd);
+    }
 
     // Look up linear channel indices for a given RBX
-    inline const std::vector<unsigned>& getRBXChannels(unsigned rbx) const
-        {return rbx_channel_lookup_.at(rbx);}
+    inline IndexRange getRBXChannels(const unsigned rbx) const
+    {
+        if (rbx >= static_cast<unsigned>(HcalHPDRBXMap::NUM_RBXS))
+            throw std::out_of_range("In HBHEChannelMap::getRBXChannels: "
+                                    "input index out of range");
+        return csrRange(rbx_channel_offsets_, rbx_channels_, rbx);
+    }
 
     // Maximum number of channels per HPD
     unsigned maxChannelsPerHPD() const;
@@ -114,27 +195,53 @@ private:
         unsigned iphi_;
     };
 
-    typedef std::map<HBHEChannelId,unsigned> ChannelMap;
+    enum {InvalidIndex = 0xffffU};
+
+    // Returns InvalidIndex for invalid triples. Unsigned arithmetic
+    // takes care of the lower bounds of the ranges.
+    inline unsigned lookupIndex(const unsigned depth, const int ieta,
+                                const unsigned iphi) const
+    {
+        const unsigned ietaShifted = ieta + MaxAbsIEta;
+        if (depth - 1U < static_cast<unsigned>(MaxDepth) &&
+            ietaShifted <= 2U*MaxAbsIEta && iphi <= MaxIPhi)
+            return inverse_[depth - 1U][ietaShifted][iphi];
+        else
+            return InvalidIndex;
+    }
 
     HBHEChannelId lookup_[ChannelCount];
-    ChannelMap inverse_;
+
+    // Dense inverse lookup table, indexed by [depth-1][ieta+29][iphi]
+    unsigned short inverse_[MaxDepth][2*MaxAbsIEta+1][MaxIPhi+1];
+
+    static inline IndexRange csrRange(const unsigned* offsets,
+                                      const unsigned* indices,
+                                      const unsigned row)
+        {return IndexRange(indices + offsets[row], indices + offsets[row+1]);}
 
     unsigned hpd_lookup_[ChannelCount];
     unsigned chan_in_hpd_lookup_[ChannelCount];
-    std::vector<std::vector<unsigned> > hpd_channel_lookup_;
+    unsigned hpd_channel_offsets_[HcalHPDRBXMap::NUM_HPDS + 1];
+    unsigned hpd_channels_[ChannelCount];
 
     unsigned rbx_lookup_[ChannelCount];
     unsigned chan_in_rbx_lookup_[ChannelCount];
-    std::vector<std::vector<unsigned> > rbx_channel_lookup_;
+    unsigned rbx_channel_offsets_[HcalHPDRBXMap::NUM_RBXS + 1];
+    unsigned rbx_channels_[ChannelCount];
 
-    std::vector<unsigned> channel_neighbors_[ChannelCount];
-    bool neighborInfoFilled_;
+    // The neighbor tables are sized in the constructor. They
+    // always have at least one element, so that taking the
+    // address of the first element is fine.
+    unsigned channel_neighbor_offsets_[ChannelCount + 1];
+    std::vector<unsigned> channel_neighbors_;
 
-    std::vector<unsigned> hpd_neighbors_[HcalHPDRBXMap::NUM_HPDS];
-    bool hpdNeighborsFilled_;
+    unsigned hpd_neighbor_offsets_[HcalHPDRBXMap::NUM_HPDS + 1];
+    std::vector<unsigned> hpd_neighbors_;
 
-    void calculateNeighborList(unsigned index, std::vector<unsigned>*) const;
-    void calculateHPDNeighbors(unsigned hpd, std::vector<unsigned>*) const;
+    // Fills at most 8 neighbors into the buffer, returns their number
+    unsigned calculateNeighborList(unsigned index, unsigned* buf) const;
+    void fillNeighborTables();
 };
 
 #endif // CondFormats_HcalObjects_HBHEChannelMap_h_
@@ -0,0 +1,192 @@
+#ifndef HPDNoiseChannelSelector_h_
+#define HPDNoiseChannelSelector_h_
+
+//
+// Channel selector which drops the channels of HPDs and RBXs showing
+// the typical noise patterns:
+//
+//   1) HPD with at least "minHPDHits" hits (HPD discharge),
+//
+//   2) RBX with at least "minRBXHits" hits (RBX-wide noise). All
+//      HPDs of such an RBX are dropped,
+//
+//   3) HPD with energy of at least "minIsolatedHPDEnergy" whose
+//      neighboring channels from other HPDs collect less than the
+//      fraction "maxNeighborFraction" of that energy (isolated HPD
+//      noise -- real showers spread over HPD boundaries).
+//
+// A hit is a channel with energy above "hitEnergyThreshold". The
+// per-HPD and per-RBX summaries are made by HPDRBXAggregator which
+// can be accessed after the "select" call.
+//
+// The AnalysisClass must provide "PulseCount", "energies()",
+// "channelData()", and "getHBHEChannelNumber(unsigned)" (the channel
+// numbers must be determined before "select" is called). The "parentPt"
+// of all channels is set to 0.
+//
+
+#include <vector>
+#include <cassert>
+#include <cstring>
+
+#include "AbsChannelSelector.h"
+#include "HPDRBXAggregator.h"
+
+template <class AnalysisClass>
+class HPDNoiseChannelSelector : public AbsChannelSelector<AnalysisClass>
+{
+public:
+    enum {
+        NHPDs = HPDRBXAggregator::NHPDs,
+        NRBXs = HPDRBXAggregator::NRBXs
+    };
+
+    inline HPDNoiseChannelSelector(const HBHEChannelMap& chmap,
+                                   const unsigned nTimeSlices,
+                                   const double hitEnergyThreshold,
+                                   const unsigned minHPDHits,
+                                   const unsigned minRBXHits,
+                                   const double minIsolatedHPDEnergy,
+                                   const double maxNeighborFraction)
+        : chmap_(chmap),
+          aggregator_(chmap, nTimeSlices),
+          hitEnergyThreshold_(hitEnergyThreshold),
+          minHPDHits_(minHPDHits),
+          minRBXHits_(minRBXHits),
+          minIsolatedHPDEnergy_(minIsolatedHPDEnergy),
+          maxNeighborFraction_(maxNeighborFraction),
+          channelNumbers_(HBHEChannelMap::ChannelCount),
+          channelEnergy_(HBHEChannelMap::ChannelCount, 0.0),
+          nNoisyHPDs_(0),
+          nNoisyRBXs_(0)
+    {
+        memset(noisyHPD_, 0, sizeof(noisyHPD_));
+        memset(noisyRBX_, 0, sizeof(noisyRBX_));
+    }
+
+    inline virtual ~HPDNoiseChannelSelector() {}
+
+    virtual void select(const AnalysisClass& event,
+                        std::vector<unsigned char>* mask,
+                        std::vector<double>* parentPt)
+    {
+        assert(mask);
+        classify(event);
+
+        // Drop the channels of the noisy HPDs
+        const unsigned n = event.PulseCount;
+        mask->resize(n);
+        const unsigned short* hpdOf = aggregator_.pulseHPD();
+        for (unsigned i=0; i<n; ++i)
+            (*mask)[i] = !noisyHPD_[hpdOf[i]];
+        if (parentPt)
+            parentPt->assign(n, 0.0);
+    }
+
+    // The noise patterns are always determined from all channels
+    // of the event, not just from the listed ones
+    virtual void selectFrom(const AnalysisClass& event,
+                            ChannelList* channels,
+                            std::vector<double>*)
+    {
+        assert(channels);
+        classify(event);
+        const unsigned nIn = channels->size();
+        unsigned* ch = nIn ? &(*channels)[0] : 0;
+        const unsigned short* hpdOf = aggregator_.pulseHPD();
+        unsigned nKept = 0;
+        for (unsigned i=0; i<nIn; ++i)
+            if (!noisyHPD_[hpdOf[ch[i]]])
+                ch[nKept++] = ch[i];
+        channels->resize(nKept);
+    }
+
+    // Results of the last "select" call
+    inline const HPDRBXAggregator& aggregator() const {return aggregator_;}
+    inline bool isNoisyHPD(const unsigned hpd) const
+        {assert(hpd < NHPDs); return noisyHPD_[hpd];}
+    inline bool isNoisyRBX(const unsigned rbx) const
+        {assert(rbx < NRBXs); return noisyRBX_[rbx];}
+    inline unsigned nNoisyHPDs() const {return nNoisyHPDs_;}
+    inline unsigned nNoisyRBXs() const {return nNoisyRBXs_;}
+
+    virtual std::size_t scratchBytes() const
+    {
+        return AbsChannelSelector<AnalysisClass>::scratchBytes() +
+            this->vectorBytes(channelNumbers_) +
+            this->vectorBytes(channelEnergy_) + aggregator_.bufferBytes();
+    }
+
+private:
+    HPDNoiseChannelSelector();
+    HPDNoiseChannelSelector(const HPDNoiseChannelSelector&);
+    HPDNoiseChannelSelector& operator=(const HPDNoiseChannelSelector&);
+
+    // Aggregate the event and find the noisy HPDs and RBXs
+    inline void classify(const AnalysisClass& event)
+    {
+        assert(event.PulseCount >= 0);
+        const unsigned n = event.PulseCount;
+        assert(n <= HBHEChannelMap::ChannelCount);
+
+        unsigned* chNum = &channelNumbers_[0];
+        for (unsigned i=0; i<n; ++i)
+            chNum[i] = event.getHBHEChannelNumber(i);
+        const double* e = event.energies();
+        aggregator_.aggregate(chNum, e, event.channelData(),
+                              hitEnergyThreshold_);
+
+        // RBX-wide noise
+        const unsigned* rbxHits = aggregator_.rbxHits();
+        nNoisyRBXs_ = 0;
+        for (unsigned r=0; r<NRBXs; ++r)
+        {
+            noisyRBX_[r] = rbxHits[r] >= minRBXHits_;
+            nNoisyRBXs_ += noisyRBX_[r];
+        }
+
+        // HPD noise. The energies of the neighboring channels are
+        // looked up by channel number, so they are spread into
+        // a dense array for the duration of this call.
+        for (unsigned i=0; i<n; ++i)
+            channelEnergy_[chNum[i]] = e[i];
+        const unsigned* hpdHits = aggregator_.hpdHits();
+        const double* hpdEnergy = aggregator_.hpdEnergy();
+        nNoisyHPDs_ = 0;
+        for (unsigned h=0; h<NHPDs; ++h)
+        {
+            bool noisy = hpdHits[h] >= minHPDHits_ ||
+                         noisyRBX_[aggregator_.hpdRBX(h)];
+            if (!noisy && hpdEnergy[h] >= minIsolatedHPDEnergy_)
+            {
+                const HBHEChannelMap::IndexRange& nb(chmap_.getHPDNeigbors(h));
+                double neighborEnergy = 0.0;
+                for (const unsigned* it = nb.begin(); it != nb.end(); ++it)
+                    neighborEnergy += channelEnergy_[*it];
+                noisy = neighborEnergy < maxNeighborFraction_*hpdEnergy[h];
+            }
+            noisyHPD_[h] = noisy;
+            nNoisyHPDs_ += noisy;
+        }
+        for (unsigned i=0; i<n; ++i)
+            channelEnergy_[chNum[i]] = 0.0;
+    }
+
+    const HBHEChannelMap& chmap_;
+    HPDRBXAggregator aggregator_;
+
+    double hitEnergyThreshold_;
+    unsigned minHPDHits_;
+    unsigned minRBXHits_;
+    double minIsolatedHPDEnergy_;
+    double maxNeighborFraction_;
+
+    std::vector<unsigned> channelNumbers_;
+    std::vector<double> channelEnergy_;
+    unsigned char noisyHPD_[NHPDs];
+    unsigned char noisyRBX_[NRBXs];
+    unsigned nNoisyHPDs_;
+    unsigned nNoisyRBXs_;
+};
+
+#endif // HPDNoiseChannelSelector_h_
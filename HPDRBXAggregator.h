@@ -0,0 +1,227 @@
+#ifndef HPDRBXAggregator_h_
+#define HPDRBXAggregator_h_
+
+//
+// Per-event HPD and RBX summaries of the HBHE channel data: the
+// pedestal-subtracted charge in every time slice, the energy, the
+// number of hits (channels with energy above a threshold), and the
+// channel with the largest energy. The results are kept in arrays
+// of length NHPDs (NRBXs) indexed by the HcalHPDRBXMap HPD (RBX)
+// number, with the charges stored time-slice-major.
+//
+// The channel-to-HPD and HPD-to-RBX tables are made in the constructor,
+// so that HBHEChannelMap is not consulted in the event loop. The HPD
+// number of every pulse is gathered once per event, after which every
+// quantity is accumulated in a single pass over contiguous arrays of
+// pulses (ChannelDataSoA for the charges). Several pulses share an HPD,
+// so the accumulation loops are scatter-adds which are not vectorized,
+// but they read the pulse arrays sequentially and make no function
+// calls. The RBX sums are made from the HPD sums rather than from the
+// channels.
+//
+
+#include <vector>
+#include <limits>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+
+#include "HBHEChannelMap.h"
+#include "HcalHPDRBXMap.h"
+#include "ChannelDataSoA.h"
+
+class HPDRBXAggregator
+{
+public:
+    enum {
+        NHPDs = HcalHPDRBXMap::NUM_HPDS,
+        NRBXs = HcalHPDRBXMap::NUM_RBXS,
+        NoChannel = HBHEChannelMap::ChannelCount
+    };
+
+    inline HPDRBXAggregator(const HBHEChannelMap& chmap,
+                            const unsigned nTimeSlices)
+        : nSlices_(nTimeSlices),
+          nPulses_(0),
+          pulseHPD_(HBHEChannelMap::ChannelCount),
+          hpdCharge_(nTimeSlices*NHPDs),
+          rbxCharge_(nTimeSlices*NRBXs)
+    {
+        assert(nSlices_);
+        for (unsigned ch=0; ch<HBHEChannelMap::ChannelCount; ++ch)
+            channelHPD_[ch] = chmap.getHPD(ch);
+        for (unsigned hpd=0; hpd<NHPDs; ++hpd)
+        {
+            const int rbx = HcalHPDRBXMap::indexRBXfromHPD(hpd);
+            assert(rbx >= 0 && rbx < NRBXs);
+            hpdRBX_[hpd] = rbx;
+        }
+        clear();
+    }
+
+    inline unsigned nTimeSlices() const {return nSlices_;}
+
+    // Number of pulses in the last aggregated event
+    inline unsigned nPulses() const {return nPulses_;}
+
+    // Fill the summaries for one event. "channelNumbers" are the linear
+    // HBHEChannelMap indices of the pulses, "energies" are their
+    // energies, and "data" holds their charges and pedestals. Channels
+    // with energy above "hitThreshold" are counted as hits.
+    template <typename PedGainReal>
+    inline void aggregate(const unsigned* channelNumbers,
+                          const double* energies,
+                          const ChannelDataSoA<PedGainReal>& data,
+                          const double hitThreshold)
+    {
+        if (data.nTimeSlices() != nSlices_)
+            throw std::invalid_argument("In HPDRBXAggregator::aggregate: "
+                                        "incompatible number of time slices");
+        const unsigned n = data.size();
+        if (n)
+        {
+            assert(channelNumbers);
+            assert(energies);
+        }
+        clear();
+        nPulses_ = n;
+
+        // Gather the HPD numbers. Check the channel numbers once,
+        // after the loop, so that the loop body has no branches.
+        unsigned short* hpdOf = &pulseHPD_[0];
+        unsigned invalid = 0;
+        for (unsigned i=0; i<n; ++i)
+        {
+            const unsigned ch = channelNumbers[i];
+            invalid |= (ch >= HBHEChannelMap::ChannelCount);
+            hpdOf[i] = channelHPD_[ch < HBHEChannelMap::ChannelCount ? ch : 0U];
+        }
+        if (invalid)
+            throw std::out_of_range("In HPDRBXAggregator::aggregate: "
+                                    "channel number out of range");
+
+        for (unsigned i=0; i<n; ++i)
+        {
+            const unsigned h = hpdOf[i];
+            const double e = energies[i];
+            hpdEnergy_[h] += e;
+            hpdHits_[h] += (e > hitThreshold);
+            if (e > hpdMaxEnergy_[h])
+            {
+                hpdMaxEnergy_[h] = e;
+                hpdMaxChannel_[h] = channelNumbers[i];
+            }
+        }
+
+        for (unsigned ts=0; ts<nSlices_; ++ts)
+        {
+            const double* q = data.charge(ts);
+            const PedGainReal* ped = data.pedestal(ts);
+            double* hq = &hpdCharge_[ts*NHPDs];
+            for (unsigned i=0; i<n; ++i)
+                hq[hpdOf[i]] += q[i] - ped[i];
+        }
+
+        // RBX sums from the HPD sums
+        for (unsigned h=0; h<NHPDs; ++h)
+        {
+            const unsigned r = hpdRBX_[h];
+            rbxEnergy_[r] += hpdEnergy_[h];
+            rbxHits_[r] += hpdHits_[h];
+            if (hpdMaxEnergy_[h] > rbxMaxEnergy_[r])
+            {
+                rbxMaxEnergy_[r] = hpdMaxEnergy_[h];
+                rbxMaxChannel_[r] = hpdMaxChannel_[h];
+            }
+        }
+        for (unsigned ts=0; ts<nSlices_; ++ts)
+        {
+            const double* hq = &hpdCharge_[ts*NHPDs];
+            double* rq = &rbxCharge_[ts*NRBXs];
+            for (unsigned h=0; h<NHPDs; ++h)
+                rq[hpdRBX_[h]] += hq[h];
+        }
+    }
+
+    // HPD number of every pulse of the last aggregated event
+    // (array of length "nPulses()")
+    inline const unsigned short* pulseHPD() const {return &pulseHPD_[0];}
+
+    // HPD and RBX lookups made in the constructor
+    inline unsigned channelHPD(const unsigned ch) const
+        {assert(ch < HBHEChannelMap::ChannelCount); return channelHPD_[ch];}
+    inline unsigned hpdRBX(const unsigned hpd) const
+        {assert(hpd < NHPDs); return hpdRBX_[hpd];}
+
+    // Arrays of length NHPDs. The maximum energy is the lowest
+    // representable double and the maximum channel is NoChannel
+    // for the HPDs without pulses.
+    inline const double* hpdCharge(const unsigned ts) const
+        {assert(ts < nSlices_); return &hpdCharge_[ts*NHPDs];}
+    inline const double* hpdEnergy() const {return hpdEnergy_;}
+    inline const unsigned* hpdHits() const {return hpdHits_;}
+    inline const double* hpdMaxEnergy() const {return hpdMaxEnergy_;}
+    inline const unsigned* hpdMaxChannel() const {return hpdMaxChannel_;}
+
+    // Arrays of length NRBXs, with the same conventions
+    inline const double* rbxCharge(const unsigned ts) const
+        {assert(ts < nSlices_); return &rbxCharge_[ts*NRBXs];}
+    inline const double* rbxEnergy() const {return rbxEnergy_;}
+    inline const unsigned* rbxHits() const {return rbxHits_;}
+    inline const double* rbxMaxEnergy() const {return rbxMaxEnergy_;}
+    inline const unsigned* rbxMaxChannel() const {return rbxMaxChannel_;}
+
+    // Heap memory of the buffers, in bytes (the fixed-size
+    // arrays are a part of the object)
+    inline std::size_t bufferBytes() const
+    {
+        return pulseHPD_.capacity()*sizeof(unsigned short) +
+            (hpdCharge_.capacity() + rbxCharge_.capacity())*sizeof(double);
+    }
+
+private:
+    HPDRBXAggregator();
+
+    inline void clear()
+    {
+        const double lowest = -std::numeric_limits<double>::max();
+        for (unsigned h=0; h<NHPDs; ++h)
+        {
+            hpdEnergy_[h] = 0.0;
+            hpdHits_[h] = 0U;
+            hpdMaxEnergy_[h] = lowest;
+            hpdMaxChannel_[h] = NoChannel;
+        }
+        for (unsigned r=0; r<NRBXs; ++r)
+        {
+            rbxEnergy_[r] = 0.0;
+            rbxHits_[r] = 0U;
+            rbxMaxEnergy_[r] = lowest;
+            rbxMaxChannel_[r] = NoChannel;
+        }
+        hpdCharge_.assign(hpdCharge_.size(), 0.0);
+        rbxCharge_.assign(rbxCharge_.size(), 0.0);
+        nPulses_ = 0;
+    }
+
+    unsigned nSlices_;
+    unsigned nPulses_;
+
+    unsigned short channelHPD_[HBHEChannelMap::ChannelCount];
+    unsigned short hpdRBX_[NHPDs];
+    std::vector<unsigned short> pulseHPD_;
+
+    std::vector<double> hpdCharge_;
+    double hpdEnergy_[NHPDs];
+    unsigned hpdHits_[NHPDs];
+    double hpdMaxEnergy_[NHPDs];
+    unsigned hpdMaxChannel_[NHPDs];
+
+    std::vector<double> rbxCharge_;
+    double rbxEnergy_[NRBXs];
+    unsigned rbxHits_[NRBXs];
+    double rbxMaxEnergy_[NRBXs];
+    unsigned rbxMaxChannel_[NRBXs];
+};
+
+#endif // HPDRBXAggregator_h_
@@ -0,0 +1,542 @@
+//
+// Reader for the "HcalTree" tree. This file was generated by
+// makeTreeReader from "HcalNoiseTree.schema" -- do not edit it, change
+// the schema and run "make readers" instead.
+//
+// Unlike the classes generated by the root "MakeClass", this reader
+// reads nothing in "GetEntry". Every branch is read by its accessor
+// method when the method is first called for the current entry, so
+// the branches which are not used are never read or decompressed.
+// The branches are read whether or not they are enabled by
+// SetBranchStatus. Declare them with RootChainProcessor::requireBranch
+// anyway, so that they are added to the TTreeCache. The cut branches
+// read by RootChainProcessor (see its "requireCutBranch") are marked
+// as loaded with "markBranchLoaded" and are not read again.
+//
+// The arrays are sized by the largest count in the current file (the
+// maximum of the counter leaf) rather than by the largest possible
+// count, and grow when a file with longer arrays is opened. The array
+// pointers returned by the accessors remain valid only until the
+// chain switches to the next file.
+//
+// "LoadTree", "GetEntry", and the accessors are not virtual, so that
+// they are inlined into the event loop when this class is the base
+// of RootChainProcessor. "Cut" and "Notify" remain virtual, as in the
+// "MakeClass" code, so that the analysis classes can override them.
+//
+// The compile-time descriptors of the branches are available as
+// HcalNoiseReader::Branch<HcalNoiseReader::<name>_id>.
+//
+
+#ifndef HcalNoiseReader_h_
+#define HcalNoiseReader_h_
+
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+#include "TTree.h"
+#include "TBranch.h"
+#include "TLeaf.h"
+
+class HcalNoiseReader
+{
+public:
+    enum BranchId
+    {
+        RunNumber_id = 0,
+        EventNumber_id,
+        LumiSection_id,
+        Bunch_id,
+        Orbit_id,
+        Time_id,
+        PulseCount_id,
+        Charge_id,
+        Pedestal_id,
+        Gain_id,
+        IEta_id,
+        IPhi_id,
+        Depth_id,
+        NBranches
+    };
+
+    // Compile-time branch descriptors. "value_type" is the type of the
+    // stored values, "counter" is the id of the counter branch (NBranches
+    // for scalars), and "width" is the number of values per array element.
+    template <unsigned Id> struct Branch;
+
+    typedef Double_t Charge_row[10];
+    typedef Double_t Pedestal_row[10];
+    typedef Double_t Gain_row[10];
+
+    inline explicit HcalNoiseReader(TTree* tree=0)
+        : fChain(0), fCurrent(-1),
+          RunNumber_(0),
+          EventNumber_(0),
+          LumiSection_(0),
+          Bunch_(0),
+          Orbit_(0),
+          Time_(0),
+          PulseCount_(0)
+    {
+        PulseCount_capacity_ = 0;
+        Init(tree);
+    }
+
+    inline virtual ~HcalNoiseReader() {}
+
+    TTree* fChain;   // The analyzed TTree or TChain
+    Int_t fCurrent;  // Current tree number in a TChain
+
+    static inline const char* treeName() {return "HcalTree";}
+
+    static inline const char* branchName(const unsigned id)
+    {
+        static const char* names[NBranches] = {
+            "RunNumber",
+            "EventNumber",
+            "LumiSection",
+            "Bunch",
+            "Orbit",
+            "Time",
+            "PulseCount",
+            "Charge",
+            "Pedestal",
+            "Gain",
+            "IEta",
+            "IPhi",
+            "Depth"};
+        return id < NBranches ? names[id] : "";
+    }
+
+    // Connect the tree or chain. The arrays are sized when the first
+    // entry of every file is loaded.
+    inline void Init(TTree* tree)
+    {
+        for (unsigned i=0; i<NBranches; ++i)
+            branches_[i] = 0;
+        fChain = tree;
+        fCurrent = -1;
+        localEntry_ = -1;
+        readEntry_ = -1;
+        loaded_ = 0;
+        bytesRead_ = 0;
+        if (!fChain) return;
+        fChain->SetMakeClass(1);
+        fChain->SetBranchAddress("RunNumber", &RunNumber_, &branches_[RunNumber_id]);
+        fChain->SetBranchAddress("EventNumber", &EventNumber_, &branches_[EventNumber_id]);
+        fChain->SetBranchAddress("LumiSection", &LumiSection_, &branches_[LumiSection_id]);
+        fChain->SetBranchAddress("Bunch", &Bunch_, &branches_[Bunch_id]);
+        fChain->SetBranchAddress("Orbit", &Orbit_, &branches_[Orbit_id]);
+        fChain->SetBranchAddress("Time", &Time_, &branches_[Time_id]);
+        fChain->SetBranchAddress("PulseCount", &PulseCount_, &branches_[PulseCount_id]);
+        resize_PulseCount(0);
+    }
+
+    inline Long64_t LoadTree(const Long64_t entry)
+    {
+        if (!fChain) return -5;
+        const Long64_t centry = fChain->LoadTree(entry);
+        if (centry < 0) return centry;
+        if (fChain->GetTreeNumber() != fCurrent)
+        {
+            fCurrent = fChain->GetTreeNumber();
+            sizeArrays();
+            Notify();
+        }
+        localEntry_ = centry;
+        readEntry_ = entry;
+        loaded_ = 0;
+        return centry;
+    }
+
+    // Nothing is read here, so the return value is 0. See "bytesRead"
+    // for the number of bytes read by the accessors.
+    inline Int_t GetEntry(const Long64_t entry)
+    {
+        if (entry != readEntry_)
+            LoadTree(entry);
+        return 0;
+    }
+
+    virtual Int_t Cut(Long64_t /* entry */) {return 1;}
+    virtual Bool_t Notify() {return kTRUE;}
+
+    inline void Show(const Long64_t entry = -1)
+        {if (fChain) fChain->Show(entry);}
+
+    inline Long64_t bytesRead() const {return bytesRead_;}
+
+    // Tell the accessors that the given branch has been read ("nbytes"
+    // bytes) for the current entry by other code. Unknown branches and
+    // failed reads are ignored.
+    inline void markBranchLoaded(const TBranch* branch,
+                                 const Int_t nbytes) const
+    {
+        if (!branch || nbytes < 0) return;
+        for (unsigned id=0; id<NBranches; ++id)
+            if (branches_[id] == branch)
+            {
+                bytesRead_ += nbytes;
+                loaded_ |= 1ULL << id;
+                return;
+            }
+    }
+
+    // Branch accessors
+    inline const Long64_t& RunNumber() const
+    {
+        if (!(loaded_ & (1ULL << RunNumber_id)))
+            loadBranch(RunNumber_id);
+        return RunNumber_;
+    }
+
+    inline const Long64_t& EventNumber() const
+    {
+        if (!(loaded_ & (1ULL << EventNumber_id)))
+            loadBranch(EventNumber_id);
+        return EventNumber_;
+    }
+
+    inline const Long64_t& LumiSection() const
+    {
+        if (!(loaded_ & (1ULL << LumiSection_id)))
+            loadBranch(LumiSection_id);
+        return LumiSection_;
+    }
+
+    inline const Long64_t& Bunch() const
+    {
+        if (!(loaded_ & (1ULL << Bunch_id)))
+            loadBranch(Bunch_id);
+        return Bunch_;
+    }
+
+    inline const Long64_t& Orbit() const
+    {
+        if (!(loaded_ & (1ULL << Orbit_id)))
+            loadBranch(Orbit_id);
+        return Orbit_;
+    }
+
+    inline const Long64_t& Time() const
+    {
+        if (!(loaded_ & (1ULL << Time_id)))
+            loadBranch(Time_id);
+        return Time_;
+    }
+
+    inline const Int_t& PulseCount() const
+    {
+        if (!(loaded_ & (1ULL << PulseCount_id)))
+            loadBranch(PulseCount_id);
+        return PulseCount_;
+    }
+
+    inline const Charge_row* Charge() const
+    {
+        if (!(loaded_ & (1ULL << Charge_id)))
+            loadArray(Charge_id, PulseCount(), PulseCount_capacity_);
+        return reinterpret_cast<const Charge_row*>(&Charge_[0]);
+    }
+
+    inline const Pedestal_row* Pedestal() const
+    {
+        if (!(loaded_ & (1ULL << Pedestal_id)))
+            loadArray(Pedestal_id, PulseCount(), PulseCount_capacity_);
+        return reinterpret_cast<const Pedestal_row*>(&Pedestal_[0]);
+    }
+
+    inline const Gain_row* Gain() const
+    {
+        if (!(loaded_ & (1ULL << Gain_id)))
+            loadArray(Gain_id, PulseCount(), PulseCount_capacity_);
+        return reinterpret_cast<const Gain_row*>(&Gain_[0]);
+    }
+
+    inline const Int_t* IEta() const
+    {
+        if (!(loaded_ & (1ULL << IEta_id)))
+            loadArray(IEta_id, PulseCount(), PulseCount_capacity_);
+        return &IEta_[0];
+    }
+
+    inline const Int_t* IPhi() const
+    {
+        if (!(loaded_ & (1ULL << IPhi_id)))
+            loadArray(IPhi_id, PulseCount(), PulseCount_capacity_);
+        return &IPhi_[0];
+    }
+
+    inline const Int_t* Depth() const
+    {
+        if (!(loaded_ & (1ULL << Depth_id)))
+            loadArray(Depth_id, PulseCount(), PulseCount_capacity_);
+        return &Depth_[0];
+    }
+
+private:
+    HcalNoiseReader(const HcalNoiseReader&);
+    HcalNoiseReader& operator=(const HcalNoiseReader&);
+
+    inline void loadBranch(const unsigned id) const
+    {
+        const Int_t nbytes = branches_[id] ?
+            branches_[id]->GetEntry(localEntry_, 1) : -1;
+        if (nbytes < 0)
+        {
+            std::ostringstream os;
+            os << "In HcalNoiseReader::loadBranch: failed to read branch \""
+               << branchName(id) << "\" for entry " << readEntry_;
+            throw std::runtime_error(os.str());
+        }
+        bytesRead_ += nbytes;
+        loaded_ |= 1ULL << id;
+    }
+
+    template <typename Count>
+    inline void loadArray(const unsigned id, const Count count,
+                          const unsigned capacity) const
+    {
+        if (count < 0 || static_cast<unsigned long long>(count) > capacity)
+        {
+            std::ostringstream os;
+            os << "In HcalNoiseReader::loadArray: count " << count
+               << " of branch \"" << branchName(id) << "\" exceeds the "
+               << "maximum " << capacity << " of the current file";
+            throw std::runtime_error(os.str());
+        }
+        loadBranch(id);
+    }
+
+    // Largest count in the current file according to the counter leaf.
+    // If the leaf does not know its maximum, the counter branch is scanned.
+    inline unsigned maxCount(const unsigned id, const long maxAllowed) const
+    {
+        Long64_t n = 0;
+        TTree* tree = fChain->GetTree();
+        if (tree)
+        {
+            TLeaf* leaf = tree->GetLeaf(branchName(id));
+            if (leaf)
+                n = leaf->GetMaximum();
+            if (n <= 0 && tree->GetEntries() > 0)
+                n = static_cast<Long64_t>(tree->GetMaximum(branchName(id)));
+        }
+        if (n < 0 || (maxAllowed >= 0 && n > maxAllowed))
+        {
+            std::ostringstream os;
+            os << "In HcalNoiseReader::maxCount: maximum " << n << " of counter \""
+               << branchName(id) << "\" is outside of the range allowed by "
+               << "the schema";
+            throw std::runtime_error(os.str());
+        }
+        return n;
+    }
+
+    inline void sizeArrays()
+    {
+        {
+            const unsigned n = maxCount(PulseCount_id, 5184L);
+            if (n > PulseCount_capacity_)
+                resize_PulseCount(n);
+        }
+    }
+
+    inline void resize_PulseCount(const unsigned n)
+    {
+        PulseCount_capacity_ = n;
+        const unsigned len = n ? n : 1U;
+        Charge_.resize(len*10U);
+        fChain->SetBranchAddress("Charge", &Charge_[0], &branches_[Charge_id]);
+        Pedestal_.resize(len*10U);
+        fChain->SetBranchAddress("Pedestal", &Pedestal_[0], &branches_[Pedestal_id]);
+        Gain_.resize(len*10U);
+        fChain->SetBranchAddress("Gain", &Gain_[0], &branches_[Gain_id]);
+        IEta_.resize(len);
+        fChain->SetBranchAddress("IEta", &IEta_[0], &branches_[IEta_id]);
+        IPhi_.resize(len);
+        fChain->SetBranchAddress("IPhi", &IPhi_[0], &branches_[IPhi_id]);
+        Depth_.resize(len);
+        fChain->SetBranchAddress("Depth", &Depth_[0], &branches_[Depth_id]);
+    }
+
+    TBranch* branches_[NBranches];
+    Long64_t localEntry_;
+    Long64_t readEntry_;
+    mutable unsigned long long loaded_;
+    mutable Long64_t bytesRead_;
+    unsigned PulseCount_capacity_;
+
+    Long64_t RunNumber_;
+    Long64_t EventNumber_;
+    Long64_t LumiSection_;
+    Long64_t Bunch_;
+    Long64_t Orbit_;
+    Long64_t Time_;
+    Int_t PulseCount_;
+    std::vector<Double_t> Charge_;
+    std::vector<Double_t> Pedestal_;
+    std::vector<Double_t> Gain_;
+    std::vector<Int_t> IEta_;
+    std::vector<Int_t> IPhi_;
+    std::vector<Int_t> Depth_;
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::RunNumber_id>
+{
+    typedef Long64_t value_type;
+    enum {
+        id = HcalNoiseReader::RunNumber_id,
+        counter = HcalNoiseReader::NBranches,
+        width = 1
+    };
+    static inline const char* name() {return "RunNumber";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::EventNumber_id>
+{
+    typedef Long64_t value_type;
+    enum {
+        id = HcalNoiseReader::EventNumber_id,
+        counter = HcalNoiseReader::NBranches,
+        width = 1
+    };
+    static inline const char* name() {return "EventNumber";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::LumiSection_id>
+{
+    typedef Long64_t value_type;
+    enum {
+        id = HcalNoiseReader::LumiSection_id,
+        counter = HcalNoiseReader::NBranches,
+        width = 1
+    };
+    static inline const char* name() {return "LumiSection";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::Bunch_id>
+{
+    typedef Long64_t value_type;
+    enum {
+        id = HcalNoiseReader::Bunch_id,
+        counter = HcalNoiseReader::NBranches,
+        width = 1
+    };
+    static inline const char* name() {return "Bunch";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::Orbit_id>
+{
+    typedef Long64_t value_type;
+    enum {
+        id = HcalNoiseReader::Orbit_id,
+        counter = HcalNoiseReader::NBranches,
+        width = 1
+    };
+    static inline const char* name() {return "Orbit";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::Time_id>
+{
+    typedef Long64_t value_type;
+    enum {
+        id = HcalNoiseReader::Time_id,
+        counter = HcalNoiseReader::NBranches,
+        width = 1
+    };
+    static inline const char* name() {return "Time";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::PulseCount_id>
+{
+    typedef Int_t value_type;
+    enum {
+        id = HcalNoiseReader::PulseCount_id,
+        counter = HcalNoiseReader::NBranches,
+        width = 1
+    };
+    static inline const char* name() {return "PulseCount";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::Charge_id>
+{
+    typedef Double_t value_type;
+    enum {
+        id = HcalNoiseReader::Charge_id,
+        counter = HcalNoiseReader::PulseCount_id,
+        width = 10
+    };
+    static inline const char* name() {return "Charge";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::Pedestal_id>
+{
+    typedef Double_t value_type;
+    enum {
+        id = HcalNoiseReader::Pedestal_id,
+        counter = HcalNoiseReader::PulseCount_id,
+        width = 10
+    };
+    static inline const char* name() {return "Pedestal";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::Gain_id>
+{
+    typedef Double_t value_type;
+    enum {
+        id = HcalNoiseReader::Gain_id,
+        counter = HcalNoiseReader::PulseCount_id,
+        width = 10
+    };
+    static inline const char* name() {return "Gain";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::IEta_id>
+{
+    typedef Int_t value_type;
+    enum {
+        id = HcalNoiseReader::IEta_id,
+        counter = HcalNoiseReader::PulseCount_id,
+        width = 1
+    };
+    static inline const char* name() {return "IEta";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::IPhi_id>
+{
+    typedef Int_t value_type;
+    enum {
+        id = HcalNoiseReader::IPhi_id,
+        counter = HcalNoiseReader::PulseCount_id,
+        width = 1
+    };
+    static inline const char* name() {return "IPhi";}
+};
+
+template <>
+struct HcalNoiseReader::Branch<HcalNoiseReader::Depth_id>
+{
+    typedef Int_t value_type;
+    enum {
+        id = HcalNoiseReader::Depth_id,
+        counter = HcalNoiseReader::PulseCount_id,
+        width = 1
+    };
+    static inline const char* name() {return "Depth";}
+};
+
+#endif // HcalNoiseReader_h_
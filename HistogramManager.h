@@ -40,6 +40,19 @@
 //    histograms, these histograms should be managed in different
 //    groups.
 //
+// The output file compression and the buffering of the managed trees
+// and ntuples can be configured with "setOutputSettings".
+//
+// Long jobs can save their progress with "writeCheckpoint" and, after
+// an interruption, continue from the saved state with the help of
+// "restoreCheckpoint".
+//
+// In the multithreaded mode, the histograms of all workers can share
+// their bins instead of being merged at the end (see "shareHistograms").
+//
+// In the online monitoring mode, the managed histograms are passed
+// to a SnapshotPublisher with "publish".
+//
 // I. Volobouev
 // March 2013
 //
@@ -49,11 +62,33 @@
 #include <regex>
 
 #include "ManagedHisto.h"
+#include "OutputSettings.h"
+#include "Checkpoint.h"
 #include "TFile.h"
 
+class SnapshotPublisher;
+class SharedHistoStore;
+struct MemoryUsage;
+
 class HistogramManager
 {
 public:
+    // Handle for a group of managed items, used to fill the group
+    // without looking it up by name. Handles are obtained from the
+    // "group" and "manage" methods and remain valid for the lifetime
+    // of the manager. The default-constructed handle refers to the
+    // default group.
+    class GroupHandle
+    {
+    public:
+        inline GroupHandle() : items_(0) {}
+
+    private:
+        friend class HistogramManager;
+        inline explicit GroupHandle(ManagedHistoContainer* c) : items_(c) {}
+        ManagedHistoContainer* items_;
+    };
+
     // We will create a new root file named "outputfile".
     //
     // "histoTags" is an arbitrary set of strings, presumably
@@ -83,8 +118,7 @@ public:
     HistogramManager(const std::string& outputfile,
                      const std::set<std::string>& histoTags);
 
-    inline virtual ~HistogramManager()
-        {if (outputfile_.IsOpen()) outputfile_.Write();}
+    virtual ~HistogramManager();
 
     // If you want to create a root histo not managed by this manager
     // but still saved into the same file, call the "cd" method before
@@ -118,8 +152,15 @@ public:
     // to call "CycleFill" with different number of cycles for
     // different objects. Then you can group together all items
     // which require the same number of cycles. If "group" argument
-    // is not provided, the default group will be used.
-    void manage(ManagedHisto* h, const char* group=0);
+    // is not provided, the default group will be used. The handle
+    // of the group is returned.
+    GroupHandle manage(ManagedHisto* h, const char* group=0);
+
+    // Handle of the group with the given name (or of the default group
+    // if the argument is NULL). The group is created, empty, if it
+    // does not exist yet, so that the handle can be obtained before
+    // it is known whether any items will be booked in the group.
+    GroupHandle group(const char* name);
 
     // By default, methods "AutoFill" and "CycleFill" will throw
     // an exception if they are called on a non-existent group
@@ -132,6 +173,46 @@ public:
     virtual void CycleFill(unsigned nCycles, const char* group=0,
                            bool throwExceptionIfGroupDoesNotExist=true);
 
+    // Versions of "AutoFill" and "CycleFill" which do not look up
+    // the group by name. Use these in the event loop.
+    inline void AutoFill(const GroupHandle g)
+    {
+        ++fillGeneration_;
+        (g.items_ ? g.items_ : &histos_)->AutoFill();
+    }
+
+    inline void CycleFill(const unsigned nCycles, const GroupHandle g)
+    {
+        ++fillGeneration_;
+        (g.items_ ? g.items_ : &histos_)->CycleFill(nCycles);
+    }
+
+    // Counter incremented at the beginning of every "AutoFill" and
+    // "CycleFill" call. It can be used to invalidate the caches of
+    // the functors shared by several items (see "Memo" in Functors.h).
+    inline const unsigned long& fillGeneration() const
+        {return fillGeneration_;}
+
+    // Set the compression of the output file and the basket size,
+    // AutoFlush, and AutoSave parameters of the managed trees and
+    // ntuples. The settings are applied to the items already managed
+    // and to all items managed later. The file compression affects
+    // the data written after this call, so this method should be
+    // called before any items are booked.
+    void setOutputSettings(const OutputSettings& s);
+
+    // Share the bins of the histograms managed from now on with the
+    // managers of the other workers of the multithreaded mode, via
+    // the given store (see "SharedHisto.h"). Exactly one of the managers
+    // must be the owner: its histograms receive the shared contents
+    // when the store is materialized. The shared items are skipped
+    // by "merge". Call this method before any items are booked.
+    // NULL store disables sharing.
+    void shareHistograms(SharedHistoStore* store, bool owner);
+
+    inline const OutputSettings& getOutputSettings() const
+        {return outputSettings_;}
+
     // Return the number of objects in the given group. 0 is returned
     // for non-existent groups.
     std::size_t NManaged(const char* group=0) const;
@@ -147,10 +228,44 @@ public:
     // Find an object in a group using its root name
     TObject* FindByName(const char* name, const char* group=0) const;
 
+    // Add the contents of all items managed by "other" to the
+    // corresponding items managed by this object. Both managers must
+    // contain identical bookings (the same items in the same groups,
+    // managed in the same order), as happens when several instances
+    // of the same analysis process different parts of one chain.
+    // Histograms are added bin by bin and ntuple rows are appended.
+    void merge(const HistogramManager& other);
+
+    // Write the current state of all managed items (and of all other
+    // objects in the output file) into the file, together with the
+    // given checkpoint record. The file remains usable if the job is
+    // killed afterwards. The surplus copies of the objects written
+    // by the previous checkpoints are deleted. The checkpoint record
+    // is removed from the file when the manager is destroyed.
+    void writeCheckpoint(const CheckpointInfo& info);
+
+    // Add the contents of the items from the output file of an earlier
+    // (interrupted) job to the corresponding managed items. The items
+    // are looked up by directory and name, so the earlier job must have
+    // booked the same items. Call this method after all items have
+    // been booked and before they are filled. Throws std::runtime_error
+    // if the file can not be read or an item is missing.
+    void restoreCheckpoint(const std::string& filename);
+
+    // Publish the current state of all managed histograms (ntuples
+    // are skipped). The publisher is cleared first.
+    void publish(SnapshotPublisher& publisher) const;
+
+    // Add the estimated memory of the managed items to "usage":
+    // the bin and sum-of-weights arrays of the histograms (counted
+    // as double precision) and the baskets of the trees and ntuples
+    void reportMemory(MemoryUsage& usage) const;
+
 private:
     typedef std::map<std::string,ManagedHistoContainer> Groups;
 
     TDirectory* findOrMakeDirectory(const std::string& dirname);
+    void applyTreeSettings(ManagedHisto* h) const;
 
     TFile outputfile_;
     std::set<std::string> requestedHistos_;
@@ -158,6 +273,12 @@ private:
     std::vector<std::regex> requestedRegex_;
     ManagedHistoContainer histos_;
     Groups groups_;
+    unsigned long fillGeneration_;
+    OutputSettings outputSettings_;
+    bool checkpointed_;
+    SharedHistoStore* sharedStore_;
+    bool sharedOwner_;
+    std::set<const TObject*> sharedItems_;
 };
 
 #endif // HistogramManager_hh_
@@ -0,0 +1,123 @@
+#ifndef JetListComparison_h_
+#define JetListComparison_h_
+
+//
+// Accumulates event-by-event differences between two jet reconstruction
+// results (for example, FFTJet run in double and in single precision)
+// and between the channel selection masks derived from them.
+//
+// The jets of the two lists are compared in the order in which they are
+// given (normally, in the order of decreasing Pt), up to the length of
+// the shorter list.
+//
+
+#include <cmath>
+#include <vector>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+
+#include "deltaPhi.h"
+
+class JetListComparison
+{
+public:
+    inline JetListComparison()
+        : nEvents_(0), nJetCountDiffers_(0), nJetsCompared_(0),
+          nChannels_(0), nMaskDiffers_(0), nMaskEventsDiffer_(0),
+          maxPtDiff_(0.0), maxRelPtDiff_(0.0), sumRelPtDiff_(0.0),
+          maxEtaDiff_(0.0), maxPhiDiff_(0.0) {}
+
+    template <class Jet>
+    void compare(const std::vector<Jet>& reference,
+                 const std::vector<Jet>& other,
+                 const std::vector<unsigned char>& referenceMask,
+                 const std::vector<unsigned char>& otherMask)
+    {
+        ++nEvents_;
+
+        const unsigned nRef = reference.size();
+        const unsigned nOther = other.size();
+        if (nRef != nOther)
+            ++nJetCountDiffers_;
+        const unsigned nJets = std::min(nRef, nOther);
+        for (unsigned i=0; i<nJets; ++i)
+        {
+            const double refPt = reference[i].vec().Pt();
+            const double dPt = std::abs(other[i].vec().Pt() - refPt);
+            const double relDPt = refPt > 0.0 ? dPt/refPt : 0.0;
+            const double dEta = std::abs(other[i].vec().Eta() -
+                                         reference[i].vec().Eta());
+            const double dPhi = std::abs(nta::deltaPhi(
+                other[i].vec().Phi(), reference[i].vec().Phi()));
+            maxPtDiff_ = std::max(maxPtDiff_, dPt);
+            maxRelPtDiff_ = std::max(maxRelPtDiff_, relDPt);
+            sumRelPtDiff_ += relDPt;
+            maxEtaDiff_ = std::max(maxEtaDiff_, dEta);
+            maxPhiDiff_ = std::max(maxPhiDiff_, dPhi);
+        }
+        nJetsCompared_ += nJets;
+
+        const unsigned long nCh = referenceMask.size();
+        assert(otherMask.size() == nCh);
+        unsigned long nDiff = 0;
+        for (unsigned long i=0; i<nCh; ++i)
+            nDiff += (referenceMask[i] != otherMask[i]);
+        nChannels_ += nCh;
+        nMaskDiffers_ += nDiff;
+        if (nDiff)
+            ++nMaskEventsDiffer_;
+    }
+
+    // Add the statistics accumulated by another object
+    inline void merge(const JetListComparison& r)
+    {
+        nEvents_ += r.nEvents_;
+        nJetCountDiffers_ += r.nJetCountDiffers_;
+        nJetsCompared_ += r.nJetsCompared_;
+        nChannels_ += r.nChannels_;
+        nMaskDiffers_ += r.nMaskDiffers_;
+        nMaskEventsDiffer_ += r.nMaskEventsDiffer_;
+        maxPtDiff_ = std::max(maxPtDiff_, r.maxPtDiff_);
+        maxRelPtDiff_ = std::max(maxRelPtDiff_, r.maxRelPtDiff_);
+        sumRelPtDiff_ += r.sumRelPtDiff_;
+        maxEtaDiff_ = std::max(maxEtaDiff_, r.maxEtaDiff_);
+        maxPhiDiff_ = std::max(maxPhiDiff_, r.maxPhiDiff_);
+    }
+
+    inline unsigned long nEvents() const {return nEvents_;}
+    inline unsigned long nJetCountDiffers() const {return nJetCountDiffers_;}
+    inline unsigned long nMaskDiffers() const {return nMaskDiffers_;}
+
+    inline void print(std::ostream& os) const
+    {
+        os << "Events compared: " << nEvents_
+           << "\nEvents with different number of jets: " << nJetCountDiffers_
+           << "\nJets compared: " << nJetsCompared_
+           << "\nMax |delta Pt|: " << maxPtDiff_
+           << "\nMax |delta Pt|/Pt: " << maxRelPtDiff_
+           << "\nMean |delta Pt|/Pt: "
+           << (nJetsCompared_ ? sumRelPtDiff_/nJetsCompared_ : 0.0)
+           << "\nMax |delta eta|: " << maxEtaDiff_
+           << "\nMax |delta phi|: " << maxPhiDiff_
+           << "\nChannels compared: " << nChannels_
+           << "\nChannels with different selection: " << nMaskDiffers_
+           << "\nEvents with different channel selection: "
+           << nMaskEventsDiffer_ << '\n';
+    }
+
+private:
+    unsigned long nEvents_;
+    unsigned long nJetCountDiffers_;
+    unsigned long nJetsCompared_;
+    unsigned long nChannels_;
+    unsigned long nMaskDiffers_;
+    unsigned long nMaskEventsDiffer_;
+    double maxPtDiff_;
+    double maxRelPtDiff_;
+    double sumRelPtDiff_;
+    double maxEtaDiff_;
+    double maxPhiDiff_;
+};
+
+#endif // JetListComparison_h_
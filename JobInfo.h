@@ -0,0 +1,169 @@
+#ifndef JobInfo_h_
+#define JobInfo_h_
+
+//
+// Description of the part of the input chain processed by one job.
+// The executables generated from "analysisExecutableTemplate.C" store
+// this information in the "JobInfo" tree of their output file (one
+// tree entry per job). When the outputs of several jobs are merged,
+// the entries are concatenated, so that the coverage of the input
+// chain by the merged file can be verified.
+//
+// The string which describes the job configuration (histogram request,
+// analysis options, etc) is stored as the title of the "JobConfiguration"
+// TNamed object. Only the outputs of identically configured jobs should
+// be merged.
+//
+
+#include <string>
+#include <vector>
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+#include "TFile.h"
+#include "TTree.h"
+#include "TNamed.h"
+
+struct JobInfo
+{
+    inline JobInfo()
+        : firstEntry(0), lastEntry(0), chainEntries(0),
+          eventsRead(0), eventsProcessed(0),
+          shard(0), nShards(1), nFiles(0)
+    {
+    }
+
+    // Range of chain entries assigned to the job, first included,
+    // last excluded, and the total number of entries in the chain
+    Long64_t firstEntry;
+    Long64_t lastEntry;
+    Long64_t chainEntries;
+
+    // Number of entries actually read and the number of entries
+    // which passed the cut. These can be smaller than the range
+    // length if the number of events to process was limited.
+    Long64_t eventsRead;
+    Long64_t eventsProcessed;
+
+    // Shard number and number of shards
+    Int_t shard;
+    Int_t nShards;
+
+    // Number of files in the input chain
+    Int_t nFiles;
+
+    inline bool isComplete() const
+        {return eventsRead == lastEntry - firstEntry;}
+};
+
+namespace Private {
+    inline void bindJobInfoBranches(TTree* tree, JobInfo* info,
+                                    const bool create)
+    {
+        struct BranchDef {const char* name; void* addr; const char* leaf;};
+        const BranchDef defs[] = {
+            {"firstEntry",      &info->firstEntry,      "firstEntry/L"},
+            {"lastEntry",       &info->lastEntry,       "lastEntry/L"},
+            {"chainEntries",    &info->chainEntries,    "chainEntries/L"},
+            {"eventsRead",      &info->eventsRead,      "eventsRead/L"},
+            {"eventsProcessed", &info->eventsProcessed, "eventsProcessed/L"},
+            {"shard",           &info->shard,           "shard/I"},
+            {"nShards",         &info->nShards,         "nShards/I"},
+            {"nFiles",          &info->nFiles,          "nFiles/I"}
+        };
+        const unsigned nDefs = sizeof(defs)/sizeof(defs[0]);
+        for (unsigned i=0; i<nDefs; ++i)
+        {
+            if (create)
+                tree->Branch(defs[i].name, defs[i].addr, defs[i].leaf);
+            else if (tree->SetBranchAddress(defs[i].name, defs[i].addr) < 0)
+            {
+                std::ostringstream os;
+                os << "In bindJobInfoBranches: branch \"" << defs[i].name
+                   << "\" not found in the JobInfo tree";
+                throw std::runtime_error(os.str());
+            }
+        }
+    }
+}
+
+// Write the job info records into the top directory of the given file
+// which must be open for writing
+inline void writeJobInfo(TFile& file, const std::vector<JobInfo>& infos)
+{
+    file.cd();
+    JobInfo info;
+    TTree* tree = new TTree("JobInfo", "Input chain ranges of the jobs");
+    Private::bindJobInfoBranches(tree, &info, true);
+    const unsigned n = infos.size();
+    for (unsigned i=0; i<n; ++i)
+    {
+        info = infos[i];
+        tree->Fill();
+    }
+    tree->Write();
+    delete tree;
+}
+
+inline void writeJobConfiguration(TFile& file, const std::string& config)
+{
+    file.cd();
+    TNamed named("JobConfiguration", config.c_str());
+    named.Write();
+}
+
+// Returns false if the file has no job configuration record
+inline bool readJobConfiguration(TFile& file, std::string* config)
+{
+    assert(config);
+    config->clear();
+    TNamed* named = 0;
+    file.GetObject("JobConfiguration", named);
+    if (!named)
+        return false;
+    *config = named->GetTitle();
+    delete named;
+    return true;
+}
+
+// Append the job info and configuration to an existing root file
+inline void writeJobInfo(const std::string& filename, const JobInfo& info,
+                         const std::string& config)
+{
+    TFile file(filename.c_str(), "UPDATE");
+    if (!file.IsOpen() || file.IsZombie())
+    {
+        std::ostringstream os;
+        os << "In writeJobInfo: failed to open file \"" << filename
+           << "\" for update";
+        throw std::runtime_error(os.str());
+    }
+    writeJobInfo(file, std::vector<JobInfo>(1, info));
+    writeJobConfiguration(file, config);
+    file.Close();
+}
+
+// Read all job info records from the given file. Returns false
+// if the file has no "JobInfo" tree.
+inline bool readJobInfo(TFile& file, std::vector<JobInfo>* infos)
+{
+    assert(infos);
+    infos->clear();
+    TTree* tree = 0;
+    file.GetObject("JobInfo", tree);
+    if (!tree)
+        return false;
+    JobInfo info;
+    Private::bindJobInfoBranches(tree, &info, false);
+    const Long64_t n = tree->GetEntries();
+    for (Long64_t i=0; i<n; ++i)
+    {
+        tree->GetEntry(i);
+        infos->push_back(info);
+    }
+    delete tree;
+    return true;
+}
+
+#endif // JobInfo_h_
@@ -16,6 +16,7 @@
 
 #include "TDirectory.h"
 
+class SharedHistoStore;
 
 struct ManagedHisto
 {
@@ -31,6 +32,13 @@ struct ManagedHisto
     virtual void SetDirectory(TDirectory* d) = 0;
     virtual const std::string& GetDirectoryName() const = 0;
     virtual TObject* GetRootItem() const = 0;
+
+    // Switch the item to the bins shared by the workers of the
+    // multithreaded mode (see "SharedHisto.h"). Items which support
+    // this should return "true". The default implementation keeps
+    // the item private to its worker.
+    inline virtual bool ShareBins(SharedHistoStore& /* store */,
+                                  bool /* owner */) {return false;}
 };
 
 
@@ -0,0 +1,335 @@
+#ifndef MemoryProfile_h_
+#define MemoryProfile_h_
+
+//
+// Memory usage instrumentation and enforcement of the memory budget.
+//
+// MemoryUsage is a snapshot of the resident set size of the process
+// together with the estimated sizes of the main memory consumers of an
+// analysis job: the reader buffers (the members of the tree class and
+// the baskets of the active input branches), the input TTreeCache, the
+// baskets of the output trees and ntuples, the histogram bins, and the
+// scratch memory of the event processing (the per-event arena and the
+// work buffers of the channel selectors). RootChainProcessor fills the
+// components it owns, and the analysis classes add their histograms
+// and output trees (normally, with HistogramManager::reportMemory) and
+// the buffers of their selectors (AbsChannelSelector::scratchBytes).
+//
+// MemoryProfile keeps the samples taken by the event loop and the peak
+// of every component. Like StageTiming, it can print a summary and write
+// its results into the "Instrumentation" directory of the output file.
+//
+// MemoryBudget is shared by all workers of a job. Once the resident size
+// exceeds 90% of the budget, the workers shrink their input caches. In
+// the multithreaded mode, the number of workers allowed to run is also
+// reduced by one every time the resident size is found still growing
+// above that mark. The excess workers wait between entries until other
+// workers finish their entry ranges, or until the resident size falls
+// below 80% of the budget, which allows one more worker at a time. A
+// waiting worker keeps the memory it holds, but stops adding to it.
+//
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <condition_variable>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TNtupleD.h"
+#include "TDirectory.h"
+
+struct MemoryUsage
+{
+    enum Component {
+        ReaderBuffers = 0,
+        InputCache,
+        OutputBaskets,
+        Histograms,
+        SelectorScratch,
+        NComponents
+    };
+
+    inline MemoryUsage() : resident(0)
+        {std::fill(bytes, bytes + NComponents, 0LL);}
+
+    static inline const char* componentName(const unsigned i)
+    {
+        static const char* names[NComponents] = {
+            "ReaderBuffers", "InputCache", "OutputBaskets", "Histograms",
+            "SelectorScratch"};
+        return i < NComponents ? names[i] : "";
+    }
+
+    inline void add(const Component c, const Long64_t nbytes)
+        {bytes[c] += nbytes;}
+
+    inline Long64_t total() const
+    {
+        Long64_t sum = 0;
+        for (unsigned i=0; i<NComponents; ++i)
+            sum += bytes[i];
+        return sum;
+    }
+
+    // Current resident set size of the process (0 if unknown)
+    static inline Long64_t residentBytes()
+    {
+        std::ifstream in("/proc/self/statm");
+        long pages = 0, resident = 0;
+        if (in >> pages >> resident)
+            return static_cast<Long64_t>(resident)*sysconf(_SC_PAGESIZE);
+        return 0;
+    }
+
+    // Largest resident set size of the process so far (0 if unknown)
+    static inline Long64_t peakResidentBytes()
+    {
+        struct rusage ru;
+        if (getrusage(RUSAGE_SELF, &ru))
+            return 0;
+#ifdef __APPLE__
+        return ru.ru_maxrss;
+#else
+        return static_cast<Long64_t>(ru.ru_maxrss)*1024LL;
+#endif
+    }
+
+    Long64_t bytes[NComponents];
+    Long64_t resident;
+};
+
+
+class MemoryProfile
+{
+public:
+    inline MemoryProfile() : peakResident_(0)
+        {std::fill(peak_, peak_ + MemoryUsage::NComponents, 0LL);}
+
+    inline void record(const Long64_t entry, const MemoryUsage& u)
+    {
+        Sample s;
+        s.entry = entry;
+        s.usage = u;
+        samples_.push_back(s);
+        for (unsigned i=0; i<MemoryUsage::NComponents; ++i)
+            if (u.bytes[i] > peak_[i])
+                peak_[i] = u.bytes[i];
+        const Long64_t rss = std::max(u.resident,
+                                      MemoryUsage::peakResidentBytes());
+        if (rss > peakResident_)
+            peakResident_ = rss;
+    }
+
+    inline unsigned nSamples() const {return samples_.size();}
+    inline Long64_t sampleEntry(const unsigned i) const
+        {return samples_.at(i).entry;}
+    inline const MemoryUsage& sample(const unsigned i) const
+        {return samples_.at(i).usage;}
+
+    inline Long64_t peak(const unsigned component) const
+    {
+        assert(component < MemoryUsage::NComponents);
+        return peak_[component];
+    }
+    inline Long64_t peakResident() const {return peakResident_;}
+
+    // Add the samples of another worker of the same job. The workers
+    // hold their components at the same time, so the component peaks
+    // are added. The resident size is that of the whole process, so
+    // the larger peak is kept.
+    inline void merge(const MemoryProfile& other)
+    {
+        samples_.insert(samples_.end(), other.samples_.begin(),
+                        other.samples_.end());
+        for (unsigned i=0; i<MemoryUsage::NComponents; ++i)
+            peak_[i] += other.peak_[i];
+        if (other.peakResident_ > peakResident_)
+            peakResident_ = other.peakResident_;
+    }
+
+    inline void print(std::ostream& os) const
+    {
+        os << "Memory usage (" << samples_.size() << " samples):\n";
+        for (unsigned i=0; i<MemoryUsage::NComponents; ++i)
+            os << "  " << std::left << std::setw(16)
+               << MemoryUsage::componentName(i) << std::right
+               << std::setw(12) << megabytes(peak_[i]) << " MB peak\n";
+        os << "  " << std::left << std::setw(16) << "ResidentSize"
+           << std::right << std::setw(12) << megabytes(peakResident_)
+           << " MB peak\n";
+        os.flush();
+    }
+
+    // Write the results into the "Instrumentation" directory of the
+    // given root file (which is updated, not recreated): the "MemoryPeak"
+    // histogram with the peak of every component and of the resident
+    // size, and the "MemorySamples" ntuple with one entry per sample.
+    // All sizes are in MB.
+    inline void write(const std::string& filename) const
+    {
+        TFile file(filename.c_str(), "UPDATE");
+        if (!file.IsOpen() || file.IsZombie())
+        {
+            std::ostringstream os;
+            os << "In MemoryProfile::write: failed to open file \""
+               << filename << '"';
+            throw std::runtime_error(os.str());
+        }
+        TDirectory* dir = file.GetDirectory("Instrumentation");
+        if (!dir)
+            dir = file.mkdir("Instrumentation");
+        assert(dir);
+        dir->cd();
+
+        const unsigned n = MemoryUsage::NComponents;
+        TH1D peaks("MemoryPeak", "Peak memory usage, MB", n + 1U, 0.0, n + 1U);
+        for (unsigned i=0; i<n; ++i)
+        {
+            peaks.GetXaxis()->SetBinLabel(i + 1, MemoryUsage::componentName(i));
+            peaks.SetBinContent(i + 1, megabytes(peak_[i]));
+        }
+        peaks.GetXaxis()->SetBinLabel(n + 1, "ResidentSize");
+        peaks.SetBinContent(n + 1, megabytes(peakResident_));
+        peaks.SetEntries(n + 1U);
+        peaks.Write();
+
+        TNtupleD nt("MemorySamples", "Memory usage samples",
+                    "entry:resident:readerBuffers:inputCache:"
+                    "outputBaskets:histograms:selectorScratch");
+        const unsigned nSamples = samples_.size();
+        for (unsigned k=0; k<nSamples; ++k)
+        {
+            const MemoryUsage& u(samples_[k].usage);
+            double row[n + 2U];
+            row[0] = samples_[k].entry;
+            row[1] = megabytes(u.resident);
+            for (unsigned i=0; i<n; ++i)
+                row[i + 2U] = megabytes(u.bytes[i]);
+            nt.Fill(row);
+        }
+        nt.Write();
+        file.Close();
+    }
+
+    static inline double megabytes(const Long64_t nbytes)
+        {return nbytes/1024.0/1024.0;}
+
+private:
+    struct Sample
+    {
+        Long64_t entry;
+        MemoryUsage usage;
+    };
+
+    std::vector<Sample> samples_;
+    Long64_t peak_[MemoryUsage::NComponents];
+    Long64_t peakResident_;
+};
+
+
+class MemoryBudget
+{
+public:
+    // "bytes" is the budget of the whole job, shared by "nWorkers"
+    // workers which all start running
+    inline MemoryBudget(const Long64_t bytes, const unsigned nWorkers)
+        : bytes_(bytes),
+          highWater_(bytes/10*9),
+          lowWater_(bytes/10*8),
+          nWorkers_(nWorkers ? nWorkers : 1U),
+          allowed_(nWorkers_),
+          running_(nWorkers_),
+          throttleResident_(0)
+    {
+        assert(bytes > 0);
+    }
+
+    inline Long64_t bytes() const {return bytes_;}
+
+    // Budget per worker at the start of the job
+    inline Long64_t share() const {return bytes_/nWorkers_;}
+
+    inline bool isExceeded(const Long64_t resident) const
+        {return resident > highWater_;}
+
+    inline unsigned allowedWorkers() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allowed_;
+    }
+
+    // Called by a running worker between entries with the current
+    // resident size. Allows one worker less if the resident size is
+    // above the high-water mark and has grown since the last reduction
+    // (so that the workers already stopped have time to take effect).
+    // Allows one worker more, and wakes up the waiting workers, if the
+    // resident size is below the low-water mark (80% of the budget).
+    // Blocks the calling worker while more workers run than allowed.
+    // Returns -1 if this call reduced the number of allowed workers,
+    // 1 if it increased that number, and 0 otherwise.
+    inline int throttle(const Long64_t resident)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        int change = 0;
+        if (resident > highWater_ && resident > throttleResident_ &&
+            allowed_ > 1U)
+        {
+            --allowed_;
+            throttleResident_ = resident;
+            change = -1;
+        }
+        else if (resident < lowWater_ && allowed_ < nWorkers_)
+        {
+            ++allowed_;
+            throttleResident_ = 0;
+            change = 1;
+            wakeup_.notify_all();
+        }
+        if (running_ > allowed_)
+        {
+            --running_;
+            wakeup_.wait(lock, [this]{return running_ < allowed_;});
+            ++running_;
+        }
+        return change;
+    }
+
+    // Must be called once by every worker when its event loop ends
+    inline void workerDone()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            assert(running_);
+            --running_;
+        }
+        wakeup_.notify_all();
+    }
+
+private:
+    MemoryBudget(const MemoryBudget&);
+    MemoryBudget& operator=(const MemoryBudget&);
+
+    const Long64_t bytes_;
+    const Long64_t highWater_;
+    const Long64_t lowWater_;
+    const unsigned nWorkers_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    unsigned allowed_;
+    unsigned running_;
+    Long64_t throttleResident_;
+};
+
+#endif // MemoryProfile_h_
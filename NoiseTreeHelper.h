@@ -1,18 +1,33 @@
 #ifndef NoiseTreeHelper_h_
 #define NoiseTreeHelper_h_
 
+#include <string>
+#include <vector>
 #include <cassert>
+#include <cstddef>
 #include "HcalNoiseTree.h"
+#include "ChannelDataSoA.h"
 
 // Number of time slices
 #define N_TIME_SLICES 10U
 
+// Define NOISETREE_FLOAT_PEDESTAL_GAIN in order to keep pedestals
+// and gains in single precision in the structure-of-arrays event data
+#ifdef NOISETREE_FLOAT_PEDESTAL_GAIN
+typedef float PedGainReal;
+#else
+typedef double PedGainReal;
+#endif
+
 class NoiseTreeHelper : public HcalNoiseTree
 {
 public:
     NoiseTreeHelper(TTree *tree=0);
     inline virtual ~NoiseTreeHelper() {}
 
+    // Reading a new entry invalidates the cached channel data and energies
+    virtual Int_t GetEntry(Long64_t entry);
+
     // Set the min/max time slices for energy determination.
     // Min time slice will be included and max excluded.
     inline void setEMinMaxTS(const unsigned tsMin, const unsigned tsMax) 
@@ -21,17 +36,94 @@ public:
         assert(tsMax <= N_TIME_SLICES);
         eMinTS_ = tsMin;
         eMaxTS_ = tsMax;
+        energiesValid_ = false;
     }
 
     inline unsigned eMinTS() const {return eMinTS_;}
     inline unsigned eMaxTS() const {return eMaxTS_;}
 
-    // Energy is calculated a-la "Method 0"
-    double energy(unsigned channelIndex) const;
+    // Energy is calculated a-la "Method 0". The energies of all
+    // "PulseCount" channels are calculated together on the first call
+    // after the entry is read, subsequent calls just look them up.
+    inline double energy(const unsigned channelIndex) const
+    {
+        assert(channelIndex < static_cast<unsigned>(PulseCount));
+        if (!energiesValid_)
+            calculateEnergies();
+        return energyCache_[channelIndex];
+    }
+
+    // Energies of all "PulseCount" channels as a contiguous array
+    // (NULL if there are no channels)
+    inline const double* energies() const
+    {
+        if (!energiesValid_)
+            calculateEnergies();
+        return energyCache_.empty() ? 0 : &energyCache_[0];
+    }
+
+    // "Charge", "Pedestal", and "Gain" of the current event arranged
+    // as contiguous per-time-slice arrays of length "PulseCount".
+    // Filled on the first call after the entry is read. The buffer
+    // grows with the largest "PulseCount" seen so far, so the array
+    // pointers are valid only for the current event.
+    inline const ChannelDataSoA<PedGainReal>& channelData() const
+    {
+        if (!soaValid_)
+        {
+            soa_.load(*this);
+            soaValid_ = true;
+        }
+        return soa_;
+    }
+
+    // Charge of the given channel in the given time slice, taken from
+    // "channelData" (so that it is loaded for the current event first)
+    inline double sliceCharge(const unsigned ts,
+                              const unsigned channelIndex) const
+    {
+        assert(channelIndex < static_cast<unsigned>(PulseCount));
+        return channelData().charge(ts)[channelIndex];
+    }
+
+    // Functor for the ntuple and tree columns which returns
+    // "sliceCharge(ts, i)" for the channel index argument i
+    class SliceCharge
+    {
+    public:
+        inline SliceCharge(const NoiseTreeHelper* helper, const unsigned ts)
+            : helper_(helper), ts_(ts) {assert(helper_);}
+        inline double operator()(const unsigned i) const
+            {return helper_->sliceCharge(ts_, i);}
+
+    private:
+        const NoiseTreeHelper* helper_;
+        unsigned ts_;
+    };
+
+    // Call this if the "Charge", "Pedestal", or "Gain" arrays
+    // are modified by something other than "GetEntry"
+    inline void invalidateEnergies()
+        {energiesValid_ = false; soaValid_ = false;}
+
+    // Heap memory used by the channel data and energy buffers, in bytes
+    // (it is not included in the size of this object)
+    inline std::size_t bufferBytes() const
+        {return soa_.bufferBytes() + energyCache_.capacity()*sizeof(double);}
+
+    // Names of the tree branches used by the "energy" method
+    static const std::vector<std::string>& energyBranches();
 
 private:
     unsigned eMinTS_;
     unsigned eMaxTS_;
+
+    mutable ChannelDataSoA<PedGainReal> soa_;
+    mutable std::vector<double> energyCache_;
+    mutable bool soaValid_;
+    mutable bool energiesValid_;
+
+    void calculateEnergies() const;
 };
 
 #endif // NoiseTreeHelper_h_
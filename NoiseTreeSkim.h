@@ -0,0 +1,181 @@
+#ifndef NoiseTreeSkim_h_
+#define NoiseTreeSkim_h_
+
+//
+// Managed tree which writes a skim of the input noise tree: the events
+// for which it is filled and, optionally, only the selected channels
+// of these events. The skim has the schema of the input tree (the
+// class generated by "MakeClass" from the input tree must be used as
+// the template parameter), except that the channel arrays are variable
+// length arrays with "PulseCount" elements. The skim can therefore be
+// processed by the same analysis programs as the original tree. When
+// the skim is managed by HistogramManager, the tree name is given by
+// the manager directory and the item name, e.g. "-t Skim/HcalTree".
+//
+// The time slice charges and pedestals can be quantized (rounded to
+// the nearest multiple of "quantum") and stored in single precision
+// (as Double32_t, which is still read into Double_t variables). Both
+// options make the skim much smaller after compression.
+//
+// Use the helper function "NoiseTreeSkim" to create instances of
+// this class.
+//
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cassert>
+#include <stdexcept>
+
+#include "TTree.h"
+
+#include "ManagedHisto.h"
+
+template <class Tree>
+class NoiseTreeSkimHelper : public ManagedHisto
+{
+public:
+    // "mask" is the channel selection mask (not owned). If it is NULL,
+    // all channels are written, otherwise only the selected ones are
+    // written, and the events without selected channels are skipped.
+    NoiseTreeSkimHelper(const char* name, const char* title,
+                        const char* directory, Tree& event,
+                        const std::vector<unsigned char>* mask,
+                        const bool singlePrecision, const double quantum)
+        : tree_(0),
+          directory_(directory),
+          event_(event),
+          mask_(mask),
+          quantum_(quantum),
+          pulseCount_(0),
+          charge_(MaxChannels*NTimeSlices),
+          pedestal_(MaxChannels*NTimeSlices),
+          gain_(MaxChannels*NTimeSlices),
+          ieta_(MaxChannels),
+          iphi_(MaxChannels),
+          depth_(MaxChannels)
+    {
+        if (quantum_ < 0.0)
+            throw std::invalid_argument("In NoiseTreeSkimHelper constructor: "
+                                        "quantum can not be negative");
+        std::ostringstream ts;
+        ts << "[PulseCount][" << NTimeSlices << "]/"
+           << (singlePrecision ? 'd' : 'D');
+        const std::string& tsLeaf = ts.str();
+
+        tree_ = new TTree(name, title);
+        tree_->Branch("RunNumber", &event_.RunNumber, "RunNumber/L");
+        tree_->Branch("EventNumber", &event_.EventNumber, "EventNumber/L");
+        tree_->Branch("LumiSection", &event_.LumiSection, "LumiSection/L");
+        tree_->Branch("Bunch", &event_.Bunch, "Bunch/L");
+        tree_->Branch("Orbit", &event_.Orbit, "Orbit/L");
+        tree_->Branch("Time", &event_.Time, "Time/L");
+        tree_->Branch("PulseCount", &pulseCount_, "PulseCount/I");
+        tree_->Branch("Charge", &charge_[0], ("Charge" + tsLeaf).c_str());
+        tree_->Branch("Pedestal", &pedestal_[0], ("Pedestal" + tsLeaf).c_str());
+        tree_->Branch("Gain", &gain_[0], ("Gain" + tsLeaf).c_str());
+        tree_->Branch("IEta", &ieta_[0], "IEta[PulseCount]/I");
+        tree_->Branch("IPhi", &iphi_[0], "IPhi[PulseCount]/I");
+        tree_->Branch("Depth", &depth_[0], "Depth[PulseCount]/I");
+    }
+
+    inline virtual ~NoiseTreeSkimHelper()
+    {
+        // Do not delete tree_ here due to the idiosyncratic
+        // root object ownership conventions
+    }
+
+    inline void AutoFill()
+    {
+        assert(event_.PulseCount >= 0);
+        const unsigned n = event_.PulseCount;
+        assert(n <= MaxChannels);
+        assert(!mask_ || mask_->size() >= n);
+        unsigned nOut = 0;
+        for (unsigned i=0; i<n; ++i)
+            if (!mask_ || (*mask_)[i])
+            {
+                copyTimeSlices(event_.Charge[i], &charge_[nOut*NTimeSlices]);
+                copyTimeSlices(event_.Pedestal[i], &pedestal_[nOut*NTimeSlices]);
+                for (unsigned ts=0; ts<NTimeSlices; ++ts)
+                    gain_[nOut*NTimeSlices + ts] = event_.Gain[i][ts];
+                ieta_[nOut] = event_.IEta[i];
+                iphi_[nOut] = event_.IPhi[i];
+                depth_[nOut] = event_.Depth[i];
+                ++nOut;
+            }
+        if (mask_ && !nOut)
+            return;
+        pulseCount_ = nOut;
+        tree_->Fill();
+    }
+    inline void CycleFill(unsigned) {}
+    inline void SetDirectory(TDirectory* d) {tree_->SetDirectory(d);}
+    inline const std::string& GetDirectoryName() const {return directory_;}
+    inline TTree* GetRootItem() const {return tree_;}
+
+    // Input tree branches needed to make the skim
+    static const std::vector<std::string>& branchNames()
+    {
+        static const char* names[] = {
+            "RunNumber", "EventNumber", "LumiSection", "Bunch", "Orbit",
+            "Time", "PulseCount", "Charge", "Pedestal", "Gain", "IEta",
+            "IPhi", "Depth"};
+        static const std::vector<std::string> v(
+            names, names + sizeof(names)/sizeof(names[0]));
+        return v;
+    }
+
+private:
+    enum {
+        MaxChannels = sizeof(Tree::IEta)/sizeof(Tree::IEta[0]),
+        NTimeSlices = sizeof(Tree::Charge[0])/sizeof(Tree::Charge[0][0])
+    };
+
+    // Branches keep the addresses of the buffers
+    NoiseTreeSkimHelper(const NoiseTreeSkimHelper&);
+    NoiseTreeSkimHelper& operator=(const NoiseTreeSkimHelper&);
+
+    inline void copyTimeSlices(const Double_t* from, Double_t* to) const
+    {
+        if (quantum_ > 0.0)
+            for (unsigned ts=0; ts<NTimeSlices; ++ts)
+                to[ts] = quantum_*std::floor(from[ts]/quantum_ + 0.5);
+        else
+            for (unsigned ts=0; ts<NTimeSlices; ++ts)
+                to[ts] = from[ts];
+    }
+
+    TTree* tree_;
+    std::string directory_;
+    Tree& event_;
+    const std::vector<unsigned char>* mask_;
+    double quantum_;
+
+    // Compacted channel data
+    Int_t pulseCount_;
+    std::vector<Double_t> charge_;
+    std::vector<Double_t> pedestal_;
+    std::vector<Double_t> gain_;
+    std::vector<Int_t> ieta_;
+    std::vector<Int_t> iphi_;
+    std::vector<Int_t> depth_;
+};
+
+//
+// The "event" argument is normally the analysis object itself (it
+// inherits the input tree variables from the "MakeClass" class).
+// Use "quantum" of 0 to write the charges and pedestals as they are.
+//
+template <class Tree>
+inline NoiseTreeSkimHelper<Tree>* NoiseTreeSkim(
+    const char* name, const char* title, const char* directory,
+    Tree& event, const std::vector<unsigned char>* mask = 0,
+    const bool singlePrecision = false, const double quantum = 0.0)
+{
+    return new NoiseTreeSkimHelper<Tree>(name, title, directory, event,
+                                         mask, singlePrecision, quantum);
+}
+
+#endif // NoiseTreeSkim_h_
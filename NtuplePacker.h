@@ -16,8 +16,40 @@
 #include "TNtuple.h"
 #include "TNtupleD.h"
 
+#include "Column.h"
+
 namespace tupleutils
 {
+    // Packing of the individual columns. These functions
+    // return the buffer position for the next column.
+    template<class Functor>
+    inline std::string columnNames(const ColumnHelper<Functor>& c)
+        {return c.name;}
+
+    template<typename T>
+    inline std::string columnNames(const ArrayColumnHelper<T>& c)
+        {return c.columnNames();}
+
+    template<class Functor, typename Real>
+    inline Real* packColumn(const ColumnHelper<Functor>& c, Real* buffer)
+        {*buffer = c.fcn(); return buffer + 1;}
+
+    template<class Functor, typename Real>
+    inline Real* packColumn(const ColumnHelper<Functor>& c, Real* buffer,
+                            const unsigned i)
+        {*buffer = c.fcn(i); return buffer + 1;}
+
+    template<typename T, typename Real>
+    inline Real* packColumn(const ArrayColumnHelper<T>& c, Real* buffer,
+                            const unsigned i = 0U)
+    {
+        const T* data = c.data(i);
+        const unsigned len = c.length;
+        for (unsigned k=0; k<len; ++k)
+            buffer[k] = data[k];
+        return buffer + len;
+    }
+
     template<typename Tuple, int N>
     struct TupleNameCycler
     {
@@ -26,7 +58,7 @@ namespace tupleutils
             TupleNameCycler<Tuple, N-1>::collect(t, s);
             if (N-1)
                 *s += ":";
-            *s += (std::get<N-1>(t)).name;
+            *s += columnNames(std::get<N-1>(t));
         }
     };
 
@@ -40,35 +72,35 @@ namespace tupleutils
     template<typename Pack, typename Real, int N>
     struct TupleFillCycler
     {
-        inline static void cycle(const Pack& p, Real* buffer)
+        inline static Real* cycle(const Pack& p, Real* buffer)
         {
-            TupleFillCycler<Pack, Real, N-1>::cycle(p, buffer);
-            buffer[N-1] = (std::get<N-1>(p)).fcn();
+            Real* b = TupleFillCycler<Pack, Real, N-1>::cycle(p, buffer);
+            return packColumn(std::get<N-1>(p), b);
         }
     };
 
     template<typename Pack, typename Real>
     struct TupleFillCycler<Pack, Real, 0>
     {
-        inline static void cycle(const Pack&, Real* buffer)
-            {assert(buffer);}
+        inline static Real* cycle(const Pack&, Real* buffer)
+            {assert(buffer); return buffer;}
     };
 
     template<typename Pack, typename Real, int N>
     struct TupleFillCycleC
     {
-        inline static void cycle(const Pack& p, Real* buffer, const unsigned i)
+        inline static Real* cycle(const Pack& p, Real* buffer, const unsigned i)
         {
-            TupleFillCycleC<Pack, Real, N-1>::cycle(p, buffer, i);
-            buffer[N-1] = (std::get<N-1>(p)).fcn(i);
+            Real* b = TupleFillCycleC<Pack, Real, N-1>::cycle(p, buffer, i);
+            return packColumn(std::get<N-1>(p), b, i);
         }
     };
 
     template<typename Pack, typename Real>
     struct TupleFillCycleC<Pack, Real, 0>
     {
-        inline static void cycle(const Pack&, Real* buffer, unsigned)
-            {assert(buffer);}
+        inline static Real* cycle(const Pack&, Real* buffer, unsigned)
+            {assert(buffer); return buffer;}
     };
 }
 
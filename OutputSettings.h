@@ -0,0 +1,115 @@
+#ifndef OutputSettings_h_
+#define OutputSettings_h_
+
+//
+// Settings of the output file written by HistogramManager: compression
+// algorithm and level, and the basket size, AutoFlush, and AutoSave
+// parameters of the managed trees and ntuples. Negative or zero values
+// mean that the root defaults are used.
+//
+// The compression algorithm numbers are those used by root in the
+// compression settings (algorithm*100 + level): 1 is zlib, 2 is LZMA,
+// 4 is LZ4, and 5 is ZSTD. For large ntuples, LZ4 compresses several
+// times faster than the default zlib at a modest cost in file size.
+//
+
+#include <string>
+#include <sstream>
+#include <stdexcept>
+
+#include "Rtypes.h"
+
+struct OutputSettings
+{
+    inline OutputSettings()
+        : compressionAlgorithm(-1),
+          compressionLevel(-1),
+          basketSize(0),
+          autoFlush(0),
+          autoSave(0)
+    {
+    }
+
+    // Parse the compression specification "algorithm[:level]", where
+    // the algorithm is one of "zlib", "lzma", "lz4", or "zstd" and the
+    // level is an integer from 0 (no compression) to 9. If the level
+    // is not given, the level recommended by root for the algorithm
+    // is used.
+    inline void parseCompression(const std::string& spec)
+    {
+        const std::size_t colon = spec.find(':');
+        const std::string alg = spec.substr(0, colon);
+        int defaultLevel = 0;
+        if (alg == "zlib")
+        {
+            compressionAlgorithm = 1;
+            defaultLevel = 1;
+        }
+        else if (alg == "lzma")
+        {
+            compressionAlgorithm = 2;
+            defaultLevel = 7;
+        }
+        else if (alg == "lz4")
+        {
+            compressionAlgorithm = 4;
+            defaultLevel = 4;
+        }
+        else if (alg == "zstd")
+        {
+            compressionAlgorithm = 5;
+            defaultLevel = 5;
+        }
+        else
+        {
+            std::ostringstream os;
+            os << "In OutputSettings::parseCompression: unknown "
+               << "compression algorithm \"" << alg << '"';
+            throw std::invalid_argument(os.str());
+        }
+        compressionLevel = defaultLevel;
+        if (colon != std::string::npos)
+        {
+            std::istringstream is(spec.substr(colon + 1));
+            int level = -1;
+            is >> level;
+            if (is.fail() || !is.eof() || level < 0 || level > 9)
+            {
+                std::ostringstream os;
+                os << "In OutputSettings::parseCompression: invalid "
+                   << "compression level in \"" << spec << '"';
+                throw std::invalid_argument(os.str());
+            }
+            compressionLevel = level;
+        }
+    }
+
+    // Value for TFile::SetCompressionSettings and
+    // TBranch::SetCompressionSettings, or -1 for the root default
+    inline int compressionSettings() const
+    {
+        if (compressionAlgorithm < 0)
+            return -1;
+        return compressionAlgorithm*100 + compressionLevel;
+    }
+
+    inline bool isDefault() const
+    {
+        return compressionAlgorithm < 0 && basketSize <= 0 &&
+               !autoFlush && !autoSave;
+    }
+
+    int compressionAlgorithm;
+    int compressionLevel;
+
+    // Basket size in bytes for all branches of the managed trees
+    Int_t basketSize;
+
+    // Passed to TTree::SetAutoFlush and TTree::SetAutoSave: positive
+    // values are numbers of entries, negative values are numbers of
+    // bytes. 0 means the root default.
+    Long64_t autoFlush;
+    Long64_t autoSave;
+};
+
+#endif // OutputSettings_h_
@@ -0,0 +1,282 @@
+#ifndef PulseShapeChannelSelector_h_
+#define PulseShapeChannelSelector_h_
+
+//
+// Channel selector which drops the channels whose time slice charge
+// distribution does not look like a physics pulse.
+//
+// The pedestal-subtracted charges d(ts) in the time slices from
+// "minTS" (included) to "maxTS" (excluded) are fitted by A*t(ts - s),
+// where t is the pulse template and s is one of the given time slice
+// shifts. The amplitude A is determined analytically for every shift
+// by weighted least squares with the charge uncertainty
+//
+//   sigma^2(ts) = noise^2 + (relativeError*d(ts))^2,
+//
+// and the smallest chi-square per degree of freedom over the shift
+// hypotheses is compared with "maxChi2". Channels whose total charge
+// in the window is below "minCharge" are not fitted and are always
+// kept: their shape is dominated by the noise.
+//
+// The fits are performed for batches of "BatchSize" channels at a time.
+// The charges of a batch are laid out time-slice-major, and the fit
+// sums are accumulated for all channels of the batch in each time
+// slice, so that the inner loops run over channels with a constant
+// template value and vectorize (one SIMD lane per channel).
+//
+// The pulse shape cut is combined with other selectors (for example,
+// FFTJetChannelSelector) by placing it into a selector chain (see
+// ChannelSelectorChain.h, and the "--channelSelector" option of
+// SelectGoodChannels). Then only the channels kept by the preceding
+// stages are fitted, and their "parentPt" values are passed through.
+//
+// The AnalysisClass must provide "PulseCount", "channelData()", and
+// "eventArena()" (used for the list of fitted channels).
+//
+
+#include <vector>
+#include <cassert>
+#include <stdexcept>
+
+#include "AbsChannelSelector.h"
+#include "ChannelDataSoA.h"
+
+template <class AnalysisClass>
+class PulseShapeChannelSelector : public AbsChannelSelector<AnalysisClass>
+{
+public:
+    enum {
+        BatchSize = 256U,
+        MaxShifts = 4U
+    };
+
+    // "pulseTemplate" must have one value per time slice of the
+    // event data. It is normalized internally.
+    inline PulseShapeChannelSelector(const std::vector<double>& pulseTemplate,
+                                     const std::vector<int>& shifts,
+                                     const unsigned minTS, const unsigned maxTS,
+                                     const double noise,
+                                     const double relativeError,
+                                     const double maxChi2,
+                                     const double minCharge)
+        : nSlices_(pulseTemplate.size()),
+          nShifts_(shifts.size()),
+          minTS_(minTS),
+          maxTS_(maxTS),
+          noise2_(noise*noise),
+          relErr2_(relativeError*relativeError),
+          maxChi2_(maxChi2),
+          minCharge_(minCharge),
+          shifts_(shifts),
+          templ_(maxTS > minTS ? (maxTS - minTS)*shifts.size() : 0U)
+    {
+        if (!nSlices_ || !(minTS_ < maxTS_ && maxTS_ <= nSlices_))
+            throw std::invalid_argument("In PulseShapeChannelSelector "
+                                        "constructor: invalid time slice range");
+        if (!nShifts_ || nShifts_ > MaxShifts)
+            throw std::invalid_argument("In PulseShapeChannelSelector "
+                                        "constructor: invalid number of shifts");
+        if (!(noise > 0.0 && relativeError >= 0.0 && maxChi2 > 0.0))
+            throw std::invalid_argument("In PulseShapeChannelSelector "
+                                        "constructor: invalid fit parameters");
+        double sum = 0.0;
+        for (unsigned ts=0; ts<nSlices_; ++ts)
+            sum += pulseTemplate[ts];
+        if (!(sum > 0.0))
+            throw std::invalid_argument("In PulseShapeChannelSelector "
+                                        "constructor: invalid pulse template");
+
+        // Shifted templates, restricted to the fit window:
+        // templ_[ihyp*nWindow + (ts - minTS)]
+        const unsigned nWindow = maxTS_ - minTS_;
+        for (unsigned ih=0; ih<nShifts_; ++ih)
+            for (unsigned ts=minTS_; ts<maxTS_; ++ts)
+            {
+                const int its = static_cast<int>(ts) - shifts_[ih];
+                templ_[ih*nWindow + ts - minTS_] =
+                    its >= 0 && its < static_cast<int>(nSlices_) ?
+                    pulseTemplate[its]/sum : 0.0;
+            }
+    }
+
+    inline virtual ~PulseShapeChannelSelector() {}
+
+    virtual void select(const AnalysisClass& event,
+                        std::vector<unsigned char>* mask,
+                        std::vector<double>* parentPt)
+    {
+        assert(mask);
+        assert(event.PulseCount >= 0);
+        const unsigned n = event.PulseCount;
+        mask->resize(n);
+        if (parentPt)
+            parentPt->assign(n, 0.0);
+
+        ChannelList all(n, 0U, ArenaAllocator<unsigned>(event.eventArena()));
+        for (unsigned i=0; i<n; ++i)
+            all[i] = i;
+        fit(event, all);
+
+        for (unsigned i=0; i<n; ++i)
+            (*mask)[i] = passes(i);
+    }
+
+    // In a selector chain, only the listed channels are fitted
+    virtual void selectFrom(const AnalysisClass& event,
+                            ChannelList* channels,
+                            std::vector<double>*)
+    {
+        assert(channels);
+        fit(event, *channels);
+        const unsigned nIn = channels->size();
+        unsigned* ch = nIn ? &(*channels)[0] : 0;
+        unsigned nKept = 0;
+        for (unsigned i=0; i<nIn; ++i)
+            if (passes(ch[i]))
+                ch[nKept++] = ch[i];
+        channels->resize(nKept);
+    }
+
+    // Results of the last "select" call, one element per pulse.
+    // The chi-square (not divided by the number of degrees of
+    // freedom) is negative for the channels which were not
+    // fitted (dropped by the preceding stages of a selector chain
+    // or below the charge cutoff).
+    inline const std::vector<double>& getChi2() const {return chi2_;}
+    inline const std::vector<double>& getAmplitude() const
+        {return amplitude_;}
+    inline const std::vector<int>& getBestShift() const {return bestShift_;}
+
+    virtual std::size_t scratchBytes() const
+    {
+        return AbsChannelSelector<AnalysisClass>::scratchBytes() +
+            this->vectorBytes(chi2_) + this->vectorBytes(amplitude_) +
+            this->vectorBytes(bestShift_);
+    }
+
+private:
+    PulseShapeChannelSelector();
+    PulseShapeChannelSelector(const PulseShapeChannelSelector&);
+    PulseShapeChannelSelector& operator=(const PulseShapeChannelSelector&);
+
+    // Fit the listed channels
+    inline void fit(const AnalysisClass& event,
+                    const ChannelList& channels)
+    {
+        assert(event.PulseCount >= 0);
+        const unsigned n = event.PulseCount;
+        chi2_.assign(n, -1.0);
+        amplitude_.assign(n, 0.0);
+        bestShift_.assign(n, 0);
+
+        const unsigned nSel = channels.size();
+        for (unsigned first=0; first<nSel; first+=BatchSize)
+        {
+            unsigned nBatch = nSel - first;
+            if (nBatch > BatchSize)
+                nBatch = BatchSize;
+            fitBatch(event.channelData(), &channels[first], nBatch);
+        }
+    }
+
+    inline bool passes(const unsigned i) const
+    {
+        const unsigned ndof = maxTS_ - minTS_ > 1U ? maxTS_ - minTS_ - 1U : 1U;
+        return !(chi2_[i] > maxChi2_*ndof);
+    }
+
+    template <typename PedGainReal>
+    inline void fitBatch(const ChannelDataSoA<PedGainReal>& data,
+                         const unsigned* idx, const unsigned nBatch)
+    {
+        if (data.nTimeSlices() != nSlices_)
+            throw std::invalid_argument("In PulseShapeChannelSelector::select: "
+                                        "incompatible number of time slices");
+        const unsigned nWindow = maxTS_ - minTS_;
+        double* swdd = sums_;
+        double* qsum = sums_ + BatchSize;
+        double* swdt = sums_ + 2U*BatchSize;
+        double* swtt = swdt + MaxShifts*BatchSize;
+        for (unsigned k=0; k<(2U + 2U*MaxShifts)*BatchSize; ++k)
+            sums_[k] = 0.0;
+
+        for (unsigned ts=minTS_; ts<maxTS_; ++ts)
+        {
+            // Gather the charges of this time slice
+            const double* q = data.charge(ts);
+            const PedGainReal* ped = data.pedestal(ts);
+            double* d = tile_;
+            double* w = tile_ + BatchSize;
+            for (unsigned l=0; l<nBatch; ++l)
+                d[l] = q[idx[l]] - ped[idx[l]];
+            for (unsigned l=0; l<nBatch; ++l)
+            {
+                w[l] = 1.0/(noise2_ + relErr2_*d[l]*d[l]);
+                swdd[l] += w[l]*d[l]*d[l];
+                qsum[l] += d[l];
+            }
+            for (unsigned ih=0; ih<nShifts_; ++ih)
+            {
+                const double t = templ_[ih*nWindow + ts - minTS_];
+                double* sdt = swdt + ih*BatchSize;
+                double* stt = swtt + ih*BatchSize;
+                for (unsigned l=0; l<nBatch; ++l)
+                {
+                    sdt[l] += w[l]*d[l]*t;
+                    stt[l] += w[l]*t*t;
+                }
+            }
+        }
+
+        // Best hypothesis for every channel
+        for (unsigned l=0; l<nBatch; ++l)
+        {
+            if (qsum[l] < minCharge_)
+                continue;
+            double best = -1.0, bestA = 0.0;
+            int bestShift = 0;
+            for (unsigned ih=0; ih<nShifts_; ++ih)
+            {
+                const double stt = swtt[ih*BatchSize + l];
+                if (stt <= 0.0)
+                    continue;
+                const double sdt = swdt[ih*BatchSize + l];
+                const double a = sdt/stt;
+                double chi2 = swdd[l] - a*sdt;
+                if (chi2 < 0.0)
+                    chi2 = 0.0;
+                if (best < 0.0 || chi2 < best)
+                {
+                    best = chi2;
+                    bestA = a;
+                    bestShift = shifts_[ih];
+                }
+            }
+            const unsigned i = idx[l];
+            chi2_[i] = best;
+            amplitude_[i] = bestA;
+            bestShift_[i] = bestShift;
+        }
+    }
+
+    unsigned nSlices_;
+    unsigned nShifts_;
+    unsigned minTS_;
+    unsigned maxTS_;
+    double noise2_;
+    double relErr2_;
+    double maxChi2_;
+    double minCharge_;
+    std::vector<int> shifts_;
+    std::vector<double> templ_;
+
+    std::vector<double> chi2_;
+    std::vector<double> amplitude_;
+    std::vector<int> bestShift_;
+
+    // Per-batch work space
+    double tile_[2U*BatchSize];
+    double sums_[(2U + 2U*MaxShifts)*BatchSize];
+};
+
+#endif // PulseShapeChannelSelector_h_
@@ -11,12 +11,79 @@
 // root-generated code is no longer used -- it is replaced by the
 // "process" method of this class.
 //
+// Derived classes which want to be run in the multithreaded mode
+// (see "processChainInParallel.h") should also implement the
+// "mergeResults" method.
+//
+// If the "Cut" method of the derived class depends only on a few
+// branches, these branches can be declared with "requireCutBranch".
+// Then only these branches are read before "Cut" is called, and
+// the remaining branches are read for the accepted entries only.
+// Readers which read their branches on demand (those generated by
+// makeTreeReader) are told about the cut branches read this way,
+// via their "markBranchLoaded" method, and do not read them again.
+//
+// Reading of the input can be overlapped with the event processing
+// by enabling the TTreeCache (see "setReadCache") and the parallel
+// basket decompression (see "setParallelUnzip").
+//
+// The time spent in the stages of the event loop can be measured by
+// calling "enableTiming" (see "StageTiming.h"). Derived classes can
+// time their own stages with "timingStage" and "stageTiming".
+//
+// Long single-threaded jobs can save their progress periodically (see
+// "setCheckpointing") and be resumed from the last checkpoint after an
+// interruption (see "setResume"). The derived classes must implement
+// "writeCheckpoint" and, when resuming, restore their results from
+// "getResumeFile()" in "beginJob".
+//
+// Instead of processing a fixed chain, "runStreamLoop" can process
+// files as they arrive (online monitoring). The histograms are then
+// published periodically via "writeSnapshot" which the derived classes
+// must implement.
+//
+// The memory used by the job can be sampled every few entries (see
+// "enableMemoryProfile" and "MemoryProfile.h"), and kept under a budget
+// shared by all workers (see "setMemoryBudget"). Derived classes add the
+// memory of their histograms and output trees in "reportMemory".
+//
+// Every processor owns an EventArena (see "EventArena.h") which is
+// reset before each call of the "event" method. Derived classes, and
+// the objects they pass themselves to, can take per-event scratch
+// memory from it via "eventArena". Since each worker of the parallel
+// mode has its own processor, the arenas are per thread.
+//
 // I. Volobouev
 // March 2013
 //
 
+#include <set>
+#include <regex>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 #include <cassert>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
 #include "TTree.h"
+#include "TChain.h"
+#include "TFile.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+
+#include "StageTiming.h"
+#include "EventArena.h"
+#include "MemoryProfile.h"
+#include "OutputSettings.h"
+#include "Checkpoint.h"
+#include "FileStreamSource.h"
+#include "SnapshotPublisher.h"
+
+class SharedHistoStore;
+class TaskPool;
 
 template <class RootMadeClass>
 class RootChainProcessor : public RootMadeClass
@@ -27,9 +94,33 @@ public:
         : RootMadeClass(tree),
           eventCounter_(0),
           processCounter_(0),
-          maxEvents_(maxEvents)
+          maxEvents_(maxEvents),
+          firstEntry_(0),
+          lastEntry_(-1),
+          sharedProcessCounter_(0),
+          workerNumber_(0),
+          sharedHistoStore_(0),
+          taskPool_(0),
+          parallelEventSize_(0),
+          cutBranchTree_(-1),
+          cacheSize_(-1),
+          cacheLearnEntries_(10),
+          overrideBranches_(false),
+          parallelUnzip_(false),
+          timingEnabled_(false),
+          checkpointEntries_(0),
+          checkpointSeconds_(0.0),
+          memoryBudget_(0),
+          memorySampleEntries_(1000),
+          entriesSinceMemorySample_(0),
+          memoryProfileEnabled_(false)
     {
         assert(tree);
+        loadTreeStage_ = timing_.addStage("LoadTree");
+        readCutStage_ = timing_.addStage("ReadCutBranches");
+        getEntryStage_ = timing_.addStage("GetEntry");
+        cutStage_ = timing_.addStage("Cut");
+        eventStage_ = timing_.addStage("Event");
     }
 
     virtual ~RootChainProcessor() {}
@@ -41,33 +132,453 @@ public:
     // returning from "main").
     inline int process()
     {
+        const int status = runEventLoop();
+        const int endStatus = finish();
+        if (status)
+            return status;
+        else
+            return endStatus;
+    }
+
+    // The two halves of "process". "runEventLoop" calls "beginJob"
+    // and then cycles over the chain entries, while "finish" calls
+    // "endJob". These methods are separated so that the results of
+    // several processors working on different parts of the chain
+    // can be merged before "endJob" is called.
+    inline int runEventLoop()
+    {
+        BudgetRelease release(memoryBudget_);
         int status = this->beginJob();
         eventCounter_ = 0;
         processCounter_ = 0;
         assert(this->fChain);
-        const Long64_t nentries = this->fChain->GetEntriesFast();
-        for (Long64_t jentry=0; jentry < nentries && !status; ++jentry)
+        if (!status)
         {
-            Long64_t ientry = this->LoadTree(jentry);
-            if (ientry < 0) break;
-            this->fChain->GetEntry(jentry);
-            ++eventCounter_;
-            if (this->Cut(ientry) < 0)
-                continue;
-            status = this->event(ientry);
-            if (++processCounter_ >= maxEvents_)
+            configureBranches();
+            configureReadCache();
+        }
+        Long64_t nentries = this->fChain->GetEntriesFast();
+        if (lastEntry_ >= 0 && lastEntry_ < nentries)
+            nentries = lastEntry_;
+        StageTiming* const timing = stageTiming();
+        const StageTiming::clock_type::time_point loopStart =
+            StageTiming::clock_type::now();
+        entriesSinceMemorySample_ = 0;
+        Long64_t lastCheckpoint = firstEntry_;
+        std::chrono::steady_clock::time_point lastCheckpointTime =
+            std::chrono::steady_clock::now();
+        for (Long64_t jentry=firstEntry_; jentry < nentries && !status; ++jentry)
+        {
+            if (checkpointDue(jentry, lastCheckpoint, lastCheckpointTime))
+            {
+                status = makeCheckpoint(jentry, nentries);
+                if (status)
+                    break;
+                lastCheckpoint = jentry;
+                lastCheckpointTime = std::chrono::steady_clock::now();
+            }
+            if (processEntry(jentry, &status))
                 break;
         }
-        const int endStatus = this->endJob();
-        if (status)
-            return status;
-        else
-            return endStatus;
+        if (!status)
+            status = this->endEventLoop();
+        if (memoryProfileEnabled_)
+            sampleMemory(nentries, false);
+        if (timing)
+            timing->setWallSeconds(std::chrono::duration<double>(
+                StageTiming::clock_type::now() - loopStart).count());
+        return status;
+    }
+
+    // Streaming replacement of "runEventLoop". The chain (which must be
+    // a TChain, possibly empty) is processed, and then the files reported
+    // by "source" are added to it and processed as they arrive. Every
+    // "snapshotSeconds", and at the end, the results are published with
+    // "writeSnapshot" (if "publisher" is not NULL). The loop ends when
+    // the source ends, when no new files arrive for "idleSeconds" (if
+    // positive), or when the requested number of events is processed.
+    // The read cache and the entry range settings are not used.
+    inline int runStreamLoop(FileStreamSource& source,
+                             SnapshotPublisher* publisher,
+                             const double snapshotSeconds,
+                             const double idleSeconds)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        TChain* chain = dynamic_cast<TChain*>(this->fChain);
+        if (!chain)
+            throw std::invalid_argument("In RootChainProcessor::runStreamLoop:"
+                                        " the input is not a TChain");
+        BudgetRelease release(memoryBudget_);
+        int status = this->beginJob();
+        eventCounter_ = 0;
+        processCounter_ = 0;
+        if (!status)
+            configureBranches();
+        StageTiming* const timing = stageTiming();
+        const StageTiming::clock_type::time_point loopStart =
+            StageTiming::clock_type::now();
+        entriesSinceMemorySample_ = 0;
+        Clock::time_point lastSnapshot = Clock::now();
+        Clock::time_point lastInput = lastSnapshot;
+        Long64_t nentries = chain->GetEntries();
+        Long64_t jentry = 0;
+        bool done = false;
+        std::vector<std::string> newFiles;
+        while (!status && !done)
+        {
+            for (; jentry < nentries && !status && !done; ++jentry)
+            {
+                done = processEntry(jentry, &status);
+                if (publisher && jentry % 64 == 63)
+                {
+                    publisher->processRequests();
+                    if (!status && std::chrono::duration<double>(
+                            Clock::now() - lastSnapshot).count() >=
+                        snapshotSeconds)
+                    {
+                        status = this->writeSnapshot(*publisher);
+                        lastSnapshot = Clock::now();
+                    }
+                }
+            }
+            if (status || done)
+                break;
+
+            // Wait for more input
+            newFiles.clear();
+            const bool more = source.poll(&newFiles, 0.5);
+            const unsigned nNew = newFiles.size();
+            for (unsigned i=0; i<nNew; ++i)
+                nentries += appendStreamFile(chain, newFiles[i]);
+            const Clock::time_point now = Clock::now();
+            if (nNew)
+                lastInput = now;
+            else if (!more || (idleSeconds > 0.0 &&
+                               std::chrono::duration<double>(
+                                   now - lastInput).count() >= idleSeconds))
+                done = true;
+            if (publisher)
+            {
+                publisher->processRequests();
+                if (std::chrono::duration<double>(
+                        now - lastSnapshot).count() >= snapshotSeconds)
+                {
+                    status = this->writeSnapshot(*publisher);
+                    lastSnapshot = Clock::now();
+                }
+            }
+        }
+        if (!status)
+            status = this->endEventLoop();
+        if (publisher && !status)
+            status = this->writeSnapshot(*publisher);
+        if (memoryProfileEnabled_)
+            sampleMemory(jentry, false);
+        if (timing)
+            timing->setWallSeconds(std::chrono::duration<double>(
+                StageTiming::clock_type::now() - loopStart).count());
+        return status;
+    }
+
+    inline int finish() {return this->endJob();}
+
+    // Restrict processing to the chain entries from "first" (included)
+    // to "last" (excluded). Negative "last" means the end of the chain.
+    inline void setEntryRange(const Long64_t first, const Long64_t last)
+    {
+        assert(first >= 0);
+        firstEntry_ = first;
+        lastEntry_ = last;
+    }
+
+    inline Long64_t getFirstEntry() const {return firstEntry_;}
+    inline Long64_t getLastEntry() const {return lastEntry_;}
+
+    // When several processors work on the same chain in parallel,
+    // the maximum number of events to process is enforced using
+    // a counter shared by all of them
+    inline void setSharedProcessCounter(std::atomic<Long64_t>* counter)
+        {sharedProcessCounter_ = counter;}
+
+    // Number of this processor in the multithreaded mode. Processor 0
+    // (also used in the single-threaded mode) collects the results of
+    // all others before its "endJob" is called, so the job summaries
+    // should normally be printed by processor 0 only.
+    inline void setWorkerNumber(const unsigned n) {workerNumber_ = n;}
+    inline unsigned getWorkerNumber() const {return workerNumber_;}
+
+    // Store of the histogram bins shared by all processors of the
+    // multithreaded mode (NULL if the histograms are not shared).
+    // Derived classes pass it to their HistogramManager in "beginJob",
+    // before booking the histograms:
+    //
+    //   manager_.shareHistograms(this->getSharedHistoStore(),
+    //                            this->getWorkerNumber() == 0U);
+    //
+    inline void setSharedHistoStore(SharedHistoStore* store)
+        {sharedHistoStore_ = store;}
+    inline SharedHistoStore* getSharedHistoStore() const
+        {return sharedHistoStore_;}
+
+    // Pool of threads (not owned, NULL if none) for the parallel loops
+    // inside the events with at least "minEventSize" elements (pulses,
+    // for the HCAL noise trees). The pool is shared by all processors
+    // of the multithreaded mode. Derived classes pass it in "beginJob"
+    // to their components which can use it.
+    inline void setTaskPool(TaskPool* pool, const unsigned minEventSize)
+        {taskPool_ = pool; parallelEventSize_ = minEventSize;}
+    inline TaskPool* getTaskPool() const {return taskPool_;}
+    inline unsigned getParallelEventSize() const
+        {return parallelEventSize_;}
+
+    // Scratch memory valid until the end of the current "event" call.
+    // The arena is not a part of the analysis state, so it is available
+    // through const references to the analysis object as well.
+    inline EventArena& eventArena() const {return eventArena_;}
+
+    // Declare a tree branch needed by the analysis. This method should be
+    // called from the analysis constructor, "beginJob", or from the code
+    // which books the histograms (typically, "bookManagedHistograms"),
+    // that is, before the event loop starts. If at least one branch is
+    // declared, all branches which have not been declared are disabled
+    // (with "SetBranchStatus") for the event loop, so that they are not
+    // read and decompressed. If nothing is declared, all branches are
+    // read. Branch names may contain the wildcards understood by
+    // "TTree::SetBranchStatus".
+    inline void requireBranch(const std::string& name)
+        {requiredBranches_.insert(name);}
+
+    inline void requireBranches(const std::vector<std::string>& names)
+        {requiredBranches_.insert(names.begin(), names.end());}
+
+    inline const std::set<std::string>& requiredBranches() const
+        {return requiredBranches_;}
+
+    // Declare a branch used by the "Cut" method. If at least one such
+    // branch is declared, the event loop reads the cut branches only
+    // (with TBranch::GetEntry), calls "Cut", and reads all other active
+    // branches only for the entries accepted by "Cut". This saves the
+    // decompression of the large branches for the rejected entries.
+    // In this mode, "Cut" must not use any branches other than the
+    // declared cut branches. The cut branches are always read, whether
+    // or not they are declared with "requireBranch". As in "requireBranch",
+    // the names may contain wildcards. These are matched against the
+    // names of the top-level branches of every tree in the chain.
+    inline void requireCutBranch(const std::string& name)
+        {cutBranches_.insert(name);}
+
+    inline const std::set<std::string>& cutBranches() const
+        {return cutBranches_;}
+
+    // Replace the set of branches declared by the analysis with the given
+    // set (normally, coming from the command line). An empty set means
+    // that the branch statuses will not be changed.
+    inline void overrideRequiredBranches(const std::set<std::string>& names)
+    {
+        branchOverride_ = names;
+        overrideBranches_ = true;
+    }
+
+    // Configure the TTreeCache of the input chain. The cache reads the
+    // baskets of all active branches for a range of entries in a single
+    // (possibly vectored) request, which hides most of the latency of
+    // remote (e.g., XRootD) inputs. "bytes" is the cache size: 0 disables
+    // the cache, a negative value (the default) leaves the root default
+    // unchanged. When the analysis (or the -b option of the main program)
+    // declares the branches to read, these branches are added to the cache
+    // directly and the learning phase is skipped. Otherwise the cache
+    // learns which branches are used from the first "learnEntries" entries.
+    // The cache entry range is restricted to the processed entry range.
+    inline void setReadCache(const Long64_t bytes, const int learnEntries=10)
+    {
+        assert(learnEntries > 0);
+        cacheSize_ = bytes;
+        cacheLearnEntries_ = learnEntries;
+    }
+
+    inline Long64_t getReadCacheSize() const {return cacheSize_;}
+
+    // If enabled, the baskets in the cache are decompressed by a helper
+    // thread (TTreeCacheUnzip) while the "event" method of this object
+    // works on the current entry. Has effect only if the cache is used.
+    inline void setParallelUnzip(const bool b) {parallelUnzip_ = b;}
+    inline bool getParallelUnzip() const {return parallelUnzip_;}
+
+    // Output file settings for the analysis. Derived classes which
+    // write their results with HistogramManager should pass these to
+    // the manager (see HistogramManager::setOutputSettings) in
+    // "beginJob", before booking the histograms and ntuples.
+    inline void setOutputSettings(const OutputSettings& s)
+        {outputSettings_ = s;}
+    inline const OutputSettings& getOutputSettings() const
+        {return outputSettings_;}
+
+    // Save the results every "nEntries" chain entries and/or every
+    // "minutes" minutes (0 means never) by calling "writeCheckpoint"
+    // between the entries. "configuration" describes the job for the
+    // checkpoint record (see Checkpoint.h). Checkpointing is not
+    // supported in the multithreaded mode.
+    inline void setCheckpointing(const Long64_t nEntries, const double minutes,
+                                 const std::string& configuration)
+    {
+        assert(nEntries >= 0);
+        assert(minutes >= 0.0);
+        checkpointEntries_ = nEntries;
+        checkpointSeconds_ = minutes*60.0;
+        resumeInfo_.configuration = configuration;
+    }
+
+    // Continue the job described by the given checkpoint record whose
+    // results are in "file". The entry range should be set to start
+    // from "info.nextEntry". The checkpoints made by this job will
+    // count the entries processed by the earlier one.
+    inline void setResume(const std::string& file, const CheckpointInfo& info)
+    {
+        resumeFile_ = file;
+        resumeInfo_.firstEntry = info.firstEntry;
+        resumeInfo_.eventsRead = info.eventsRead;
+        resumeInfo_.eventsProcessed = info.eventsProcessed;
+    }
+
+    inline bool isResuming() const {return !resumeFile_.empty();}
+    inline const std::string& getResumeFile() const {return resumeFile_;}
+
+    // Measure the time spent in the stages of the event loop:
+    // "LoadTree", "ReadCutBranches", "GetEntry", "Cut", and "Event"
+    // (the "event" method), together with any stages added by the
+    // derived class. The number of bytes read by "GetEntry" and the
+    // wall clock time of the event loop are recorded as well.
+    inline void enableTiming(const bool b) {timingEnabled_ = b;}
+    inline bool timingEnabled() const {return timingEnabled_;}
+
+    // The timing results (meaningful only if the timing is enabled)
+    inline const StageTiming& getTiming() const {return timing_;}
+
+    // Sample the memory usage (see "memoryUsage") before every
+    // "sampleEntries"-th entry and at the end of the event loop
+    inline void enableMemoryProfile(const bool b,
+                                    const Long64_t sampleEntries=1000)
+    {
+        assert(sampleEntries > 0);
+        memoryProfileEnabled_ = b;
+        memorySampleEntries_ = sampleEntries;
+    }
+    inline bool memoryProfileEnabled() const {return memoryProfileEnabled_;}
+
+    // The memory samples (meaningful only if the profile is enabled)
+    inline const MemoryProfile& getMemoryProfile() const
+        {return memoryProfile_;}
+
+    // Memory budget shared by all processors of the job (not owned,
+    // NULL if none). Setting a budget enables the memory profile. When
+    // the resident size of the process approaches the budget, the
+    // processor shrinks its read cache and lets the budget stop some
+    // of the workers (see MemoryBudget::throttle) between entries.
+    inline void setMemoryBudget(MemoryBudget* budget)
+    {
+        memoryBudget_ = budget;
+        if (budget)
+            memoryProfileEnabled_ = true;
+    }
+    inline MemoryBudget* getMemoryBudget() const {return memoryBudget_;}
+
+    // Current memory usage of this processor. The reader buffers are
+    // estimated from the size of this object (which includes the arrays
+    // of the root-generated class) and the basket sizes of the active
+    // branches of the current tree. The selector scratch starts with the
+    // capacity of the event arena. The output baskets and histograms,
+    // the heap buffers of the reader class (e.g., those of
+    // NoiseTreeHelper), and the buffers of the channel selectors are
+    // added by "reportMemory".
+    inline MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage;
+        usage.add(MemoryUsage::ReaderBuffers, sizeof(*this));
+        const TTree* chain = this->fChain;
+        if (chain)
+        {
+            TTree* tree = chain->GetTree();
+            if (tree)
+            {
+                TObjArray* branches = tree->GetListOfBranches();
+                const Int_t nBranches = branches ? branches->GetEntriesFast() : 0;
+                for (Int_t i=0; i<nBranches; ++i)
+                {
+                    const TBranch* b = static_cast<const TBranch*>(
+                        branches->UncheckedAt(i));
+                    if (b && tree->GetBranchStatus(b->GetName()))
+                        usage.add(MemoryUsage::ReaderBuffers, b->GetBasketSize());
+                }
+            }
+            usage.add(MemoryUsage::InputCache, chain->GetCacheSize());
+        }
+        usage.add(MemoryUsage::SelectorScratch, eventArena_.capacity());
+        usage.resident = MemoryUsage::residentBytes();
+        this->reportMemory(usage);
+        return usage;
     }
 
     inline Long64_t getEventCounter() const {return eventCounter_;}
     inline Long64_t getProcessCounter() const {return processCounter_;}
 
+    // The following method is called in the multithreaded mode after
+    // all processors have finished their event loops, before "endJob".
+    // It is called on the processor which handled the first part of
+    // the chain, once for every other processor, in the order of
+    // their entry ranges. The argument will be of the same dynamic
+    // type as this object. Derived classes should add the results
+    // accumulated by "other" (histograms, ntuples, counters, etc)
+    // to their own. The default implementation simply reports that
+    // merging is not supported.
+    virtual int mergeResults(RootChainProcessor& /* other */)
+    {
+        std::cerr << "Error in RootChainProcessor::mergeResults: "
+                  << "this analysis does not support multithreaded "
+                  << "processing" << std::endl;
+        return 1;
+    }
+
+    // The following method is called by the event loop when a checkpoint
+    // is due (see "setCheckpointing"). Derived classes should save their
+    // results together with the given record, normally by calling
+    // HistogramManager::writeCheckpoint. The results must be saved so
+    // that "beginJob" can restore them when the job is resumed. The
+    // default implementation reports that checkpointing is not supported.
+    virtual int writeCheckpoint(const CheckpointInfo& /* info */)
+    {
+        std::cerr << "Error in RootChainProcessor::writeCheckpoint: "
+                  << "this analysis does not support checkpointing"
+                  << std::endl;
+        return 1;
+    }
+
+    // The following method is called by "runEventLoop" and "runStreamLoop"
+    // after the last entry, before the results are merged or published.
+    // Derived classes which queue events inside "event" (for example, to
+    // pass them to the channel selectors in batches) should process the
+    // remaining queued events here. The default implementation does nothing.
+    virtual int endEventLoop() {return 0;}
+
+    // The following method is called when the memory usage is sampled.
+    // Derived classes should add the memory of their histograms and output
+    // trees to "usage", normally by calling HistogramManager::reportMemory,
+    // together with any large buffers of their own. The default
+    // implementation adds nothing.
+    virtual void reportMemory(MemoryUsage& /* usage */) const {}
+
+    // The following method is called by "runStreamLoop" when a snapshot
+    // of the results is due. Derived classes should pass their histograms
+    // to the publisher, normally by calling HistogramManager::publish.
+    // The default implementation reports that snapshots are not supported.
+    virtual int writeSnapshot(SnapshotPublisher& /* publisher */)
+    {
+        std::cerr << "Error in RootChainProcessor::writeSnapshot: "
+                  << "this analysis does not support the streaming mode"
+                  << std::endl;
+        return 1;
+    }
+
 protected:
     // Derived classes should override the following
     // three methods. If these methods return anything
@@ -76,6 +587,19 @@ protected:
     virtual int event(Long64_t entryNumber) = 0;
     virtual int endJob() = 0;
 
+    // Register a timed stage of the derived class (normally, in its
+    // constructor) and return the stage number to use with
+    // ScopedStageTimer. For example:
+    //
+    //   ScopedStageTimer t(this->stageTiming(), selectStage_);
+    //
+    inline unsigned timingStage(const std::string& name)
+        {return timing_.addStage(name);}
+
+    // Returns NULL if the timing is disabled
+    inline StageTiming* stageTiming()
+        {return timingEnabled_ ? &timing_ : 0;}
+
 private:
     // Disable default constructors and assignment operator
     RootChainProcessor();
@@ -85,6 +609,406 @@ private:
     Long64_t eventCounter_;
     Long64_t processCounter_;
     Long64_t maxEvents_;
+    Long64_t firstEntry_;
+    Long64_t lastEntry_;
+    std::atomic<Long64_t>* sharedProcessCounter_;
+    unsigned workerNumber_;
+    SharedHistoStore* sharedHistoStore_;
+    TaskPool* taskPool_;
+    unsigned parallelEventSize_;
+    std::set<std::string> requiredBranches_;
+    std::set<std::string> branchOverride_;
+    std::set<std::string> cutBranches_;
+    std::vector<TBranch*> cutBranchPtrs_;
+    Int_t cutBranchTree_;
+    Long64_t cacheSize_;
+    int cacheLearnEntries_;
+    bool overrideBranches_;
+    bool parallelUnzip_;
+    bool timingEnabled_;
+    StageTiming timing_;
+    mutable EventArena eventArena_;
+    OutputSettings outputSettings_;
+    Long64_t checkpointEntries_;
+    double checkpointSeconds_;
+    CheckpointInfo resumeInfo_;
+    std::string resumeFile_;
+    unsigned loadTreeStage_;
+    unsigned readCutStage_;
+    unsigned getEntryStage_;
+    unsigned cutStage_;
+    unsigned eventStage_;
+    MemoryProfile memoryProfile_;
+    MemoryBudget* memoryBudget_;
+    Long64_t memorySampleEntries_;
+    Long64_t entriesSinceMemorySample_;
+    bool memoryProfileEnabled_;
+
+    // Tells the budget that the event loop of this processor
+    // has ended, whichever way the loop is left
+    class BudgetRelease
+    {
+    public:
+        inline explicit BudgetRelease(MemoryBudget* b) : budget_(b) {}
+        inline ~BudgetRelease() {if (budget_) budget_->workerDone();}
+
+    private:
+        BudgetRelease(const BudgetRelease&);
+        BudgetRelease& operator=(const BudgetRelease&);
+
+        MemoryBudget* budget_;
+    };
+
+    // The clock is consulted only every 64 entries
+    inline bool checkpointDue(
+        const Long64_t jentry, const Long64_t lastCheckpoint,
+        const std::chrono::steady_clock::time_point& lastTime) const
+    {
+        const Long64_t n = jentry - lastCheckpoint;
+        if (n <= 0)
+            return false;
+        if (checkpointEntries_ > 0 && n >= checkpointEntries_)
+            return true;
+        if (checkpointSeconds_ > 0.0 && n % 64 == 0)
+            return std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - lastTime).count() >=
+                checkpointSeconds_;
+        return false;
+    }
+
+    inline int makeCheckpoint(const Long64_t nextEntry, const Long64_t nentries)
+    {
+        CheckpointInfo info(resumeInfo_);
+        if (!isResuming())
+            info.firstEntry = firstEntry_;
+        info.nextEntry = nextEntry;
+        info.lastEntry = nentries;
+        info.eventsRead += eventCounter_;
+        info.eventsProcessed += processCounter_;
+        const TFile* file = this->fChain->GetCurrentFile();
+        if (file)
+            info.inputFile = file->GetName();
+        return this->writeCheckpoint(info);
+    }
+
+    // Read and process one chain entry. Returns true if
+    // the event loop should be terminated.
+    inline bool processEntry(const Long64_t jentry, int* status)
+    {
+        if (memoryProfileEnabled_ &&
+            ++entriesSinceMemorySample_ >= memorySampleEntries_)
+        {
+            sampleMemory(jentry, true);
+            entriesSinceMemorySample_ = 0;
+        }
+        StageTiming* const timing = stageTiming();
+        Long64_t ientry;
+        {
+            ScopedStageTimer t(timing, loadTreeStage_);
+            ientry = this->LoadTree(jentry);
+        }
+        if (ientry < 0) return true;
+        if (cutBranches_.empty())
+        {
+            timedGetEntry(jentry);
+            ++eventCounter_;
+            if (timedCut(ientry) < 0)
+                return false;
+        }
+        else
+        {
+            // Two-phase read: the cut branches first,
+            // everything else only if the entry passes
+            readCutBranches(ientry);
+            ++eventCounter_;
+            if (timedCut(ientry) < 0)
+                return false;
+            timedGetEntry(jentry);
+        }
+        if (sharedProcessCounter_)
+            if (sharedProcessCounter_->fetch_add(1) >= maxEvents_)
+                return true;
+        {
+            ScopedStageTimer t(timing, eventStage_);
+            eventArena_.reset();
+            *status = this->event(ientry);
+        }
+        return ++processCounter_ >= maxEvents_;
+    }
+
+    // Record the memory usage before the given entry. If "enforce" is
+    // true, let the budget decide whether this worker should wait and,
+    // if the budget is exceeded, halve the read cache (down to 1 MB).
+    inline void sampleMemory(const Long64_t jentry, const bool enforce)
+    {
+        const MemoryUsage usage(memoryUsage());
+        memoryProfile_.record(jentry, usage);
+        if (!(enforce && memoryBudget_))
+            return;
+
+        const Long64_t minCache = 1024LL*1024LL;
+        const Long64_t cache = usage.bytes[MemoryUsage::InputCache];
+        if (memoryBudget_->isExceeded(usage.resident) && cache > minCache)
+        {
+            const Long64_t newCache = std::max(cache/2, minCache);
+            this->fChain->SetCacheSize(newCache);
+            cacheSize_ = newCache;
+            std::cerr << "Warning in RootChainProcessor: worker "
+                      << workerNumber_ << " is over the memory budget, "
+                      << "read cache reduced to " << newCache << " bytes"
+                      << std::endl;
+        }
+        const int change = memoryBudget_->throttle(usage.resident);
+        if (change < 0)
+            std::cerr << "Warning in RootChainProcessor: memory budget "
+                      << "exceeded, the number of running workers is "
+                      << "reduced to " << memoryBudget_->allowedWorkers()
+                      << std::endl;
+        else if (change > 0)
+            std::cerr << "Warning in RootChainProcessor: memory usage "
+                      << "is back under the budget, the number of running "
+                      << "workers is increased to "
+                      << memoryBudget_->allowedWorkers() << std::endl;
+    }
+
+    // Add a file to the chain in the streaming mode. Returns the number
+    // of added entries. Files without the chain tree are skipped.
+    inline Long64_t appendStreamFile(TChain* chain, const std::string& name)
+    {
+        Long64_t n = -1;
+        TDirectory* saved = gDirectory;
+        {
+            TFile* f = TFile::Open(name.c_str(), "READ");
+            if (f && !f->IsZombie())
+            {
+                TTree* t = 0;
+                f->GetObject(chain->GetName(), t);
+                if (t)
+                    n = t->GetEntries();
+            }
+            delete f;
+        }
+        if (saved)
+            saved->cd();
+        if (n < 0)
+        {
+            std::cerr << "Warning in RootChainProcessor::runStreamLoop: "
+                      << "tree \"" << chain->GetName() << "\" not found "
+                      << "in file \"" << name << "\", file skipped"
+                      << std::endl;
+            return 0;
+        }
+        if (n > 0)
+            chain->Add(name.c_str(), n);
+        return n;
+    }
+
+    inline void timedGetEntry(const Long64_t entry)
+    {
+        StageTiming* const timing = stageTiming();
+        ScopedStageTimer t(timing, getEntryStage_);
+        const Int_t nbytes = this->GetEntry(entry);
+        if (timing && nbytes > 0)
+            timing->addBytesRead(nbytes);
+    }
+
+    inline Int_t timedCut(const Long64_t localEntry)
+    {
+        ScopedStageTimer t(stageTiming(), cutStage_);
+        return this->Cut(localEntry);
+    }
+
+    inline const std::set<std::string>& activeBranches() const
+        {return overrideBranches_ ? branchOverride_ : requiredBranches_;}
+
+    inline void configureBranches()
+    {
+        cutBranchTree_ = -1;
+        const std::set<std::string>& active = activeBranches();
+        if (active.empty() && cutBranches_.empty())
+            return;
+
+        // Make sure that branch names which do not contain
+        // wildcards really exist in the tree
+        TTree* tree = this->fChain;
+        if (tree->LoadTree(firstEntry_) >= 0)
+        {
+            checkBranchesExist(tree, active, "branch");
+            checkBranchesExist(tree, cutBranches_, "cut branch");
+        }
+
+        if (active.empty())
+            return;
+        tree->SetBranchStatus("*", 0);
+        const std::set<std::string>::const_iterator end = active.end();
+        for (std::set<std::string>::const_iterator it = active.begin();
+             it != end; ++it)
+            tree->SetBranchStatus(it->c_str(), 1);
+        const std::set<std::string>::const_iterator cend = cutBranches_.end();
+        for (std::set<std::string>::const_iterator it = cutBranches_.begin();
+             it != cend; ++it)
+            tree->SetBranchStatus(it->c_str(), 1);
+    }
+
+    // Tell the reader that a cut branch has been read, if the reader
+    // keeps track of the branches it has loaded (see makeTreeReader.C)
+    template <class Reader>
+    static inline auto markCutBranch(const Reader& reader, const TBranch* b,
+                                     const Int_t nbytes, int)
+        -> decltype(reader.markBranchLoaded(b, nbytes), void())
+        {reader.markBranchLoaded(b, nbytes);}
+
+    template <class Reader>
+    static inline void markCutBranch(const Reader&, const TBranch*,
+                                     Int_t, long) {}
+
+    static inline bool hasWildcards(const std::string& name)
+        {return name.find_first_of("*?[]") != std::string::npos;}
+
+    // Regular expression equivalent to the branch name wildcards
+    static inline std::regex wildcardRegex(const std::string& pattern)
+    {
+        std::string re;
+        bool inBrackets = false;
+        const unsigned len = pattern.size();
+        for (unsigned i=0; i<len; ++i)
+        {
+            const char c = pattern[i];
+            if (inBrackets)
+            {
+                re += c;
+                if (c == ']')
+                    inBrackets = false;
+            }
+            else if (c == '*')
+                re += ".*";
+            else if (c == '?')
+                re += '.';
+            else if (c == '[')
+            {
+                re += c;
+                inBrackets = true;
+            }
+            else
+            {
+                if (std::string("\\^$.|+(){}]").find(c) != std::string::npos)
+                    re += '\\';
+                re += c;
+            }
+        }
+        return std::regex(re);
+    }
+
+    static inline void checkBranchesExist(TTree* tree,
+                                          const std::set<std::string>& names,
+                                          const char* what)
+    {
+        const std::set<std::string>::const_iterator end = names.end();
+        for (std::set<std::string>::const_iterator it = names.begin();
+             it != end; ++it)
+            if (!hasWildcards(*it) && !tree->GetBranch(it->c_str()))
+            {
+                std::ostringstream os;
+                os << "In RootChainProcessor::configureBranches: "
+                   << what << " \"" << *it << "\" not found";
+                throw std::invalid_argument(os.str());
+            }
+    }
+
+    // Read the cut branches of the current tree in the chain. The branch
+    // pointers are looked up again (and the wildcards are matched again)
+    // whenever the chain switches trees.
+    inline void readCutBranches(const Long64_t localEntry)
+    {
+        TTree* tree = this->fChain;
+        const Int_t treeNumber = tree->GetTreeNumber();
+        if (treeNumber != cutBranchTree_)
+        {
+            cutBranchPtrs_.clear();
+            const std::set<std::string>::const_iterator end = cutBranches_.end();
+            for (std::set<std::string>::const_iterator it = cutBranches_.begin();
+                 it != end; ++it)
+            {
+                if (hasWildcards(*it))
+                {
+                    const std::regex re(wildcardRegex(*it));
+                    TObjArray* branches = tree->GetTree()->GetListOfBranches();
+                    const Int_t nb = branches ? branches->GetEntriesFast() : 0;
+                    for (Int_t ib=0; ib<nb; ++ib)
+                    {
+                        TBranch* b = static_cast<TBranch*>(branches->At(ib));
+                        if (b && std::regex_match(b->GetName(), re))
+                            cutBranchPtrs_.push_back(b);
+                    }
+                    continue;
+                }
+                TBranch* b = tree->GetBranch(it->c_str());
+                if (!b)
+                {
+                    std::ostringstream os;
+                    os << "In RootChainProcessor::readCutBranches: "
+                       << "cut branch \"" << *it << "\" not found in tree "
+                       << treeNumber << " of the chain";
+                    throw std::runtime_error(os.str());
+                }
+                cutBranchPtrs_.push_back(b);
+            }
+            cutBranchTree_ = treeNumber;
+        }
+        StageTiming* const timing = stageTiming();
+        ScopedStageTimer t(timing, readCutStage_);
+        const unsigned nCut = cutBranchPtrs_.size();
+        for (unsigned i=0; i<nCut; ++i)
+        {
+            const Int_t nbytes = cutBranchPtrs_[i]->GetEntry(localEntry);
+            if (timing && nbytes > 0)
+                timing->addBytesRead(nbytes);
+            markCutBranch(static_cast<const RootMadeClass&>(*this),
+                          cutBranchPtrs_[i], nbytes, 0);
+        }
+    }
+
+    inline void configureReadCache()
+    {
+        TTree* tree = this->fChain;
+        if (parallelUnzip_ && cacheSize_)
+            tree->SetParallelUnzip(kTRUE);
+        if (cacheSize_ >= 0)
+            tree->SetCacheSize(cacheSize_);
+        if (!cacheSize_)
+            return;
+
+        tree->SetCacheEntryRange(firstEntry_, lastEntry_ >= 0 ?
+                                 lastEntry_ : tree->GetEntriesFast());
+
+        // The cache understands no wildcards other than "*". The cut
+        // branches are read for every entry, so they must be cached
+        // as well.
+        const std::set<std::string>& active = activeBranches();
+        bool canAdd = !active.empty();
+        const std::set<std::string>::const_iterator end = active.end();
+        for (std::set<std::string>::const_iterator it = active.begin();
+             it != end && canAdd; ++it)
+            if (*it != "*" && hasWildcards(*it))
+                canAdd = false;
+        const std::set<std::string>::const_iterator cend = cutBranches_.end();
+        for (std::set<std::string>::const_iterator it = cutBranches_.begin();
+             it != cend && canAdd; ++it)
+            if (*it != "*" && hasWildcards(*it))
+                canAdd = false;
+        if (canAdd)
+        {
+            for (std::set<std::string>::const_iterator it = active.begin();
+                 it != end; ++it)
+                tree->AddBranchToCache(it->c_str(), kTRUE);
+            for (std::set<std::string>::const_iterator it = cutBranches_.begin();
+                 it != cend; ++it)
+                tree->AddBranchToCache(it->c_str(), kTRUE);
+            tree->StopCacheLearningPhase();
+        }
+        else
+            tree->SetCacheLearnEntries(cacheLearnEntries_);
+    }
 };
 
 #endif // RootChainProcessor_h_
@@ -14,6 +14,10 @@
 #include "HBHEChannelMap.h"
 #include "ChannelChargeInfo.h"
 #include "AbsChannelSelector.h"
+#include "EntryQueue.h"
+#include "FFTJetChannelSelector.h"
+#include "FFTJetResultCache.h"
+#include "JetListComparison.h"
 #include "JetSummary.h"
 
 // The class template parameters are:
@@ -81,10 +85,29 @@ public:
     // "Notify" if you want a notification when a new file is opened in
     // the TChain, and override "Cut" if some events should be skipped
     // (the "event" method will not be called if "Cut" returns a negative
-    // number).
+    // number). If "Cut" uses only a few small branches, declare them
+    // in the constructor with "requireCutBranch" (see RootChainProcessor.h),
+    // so that the remaining branches are read for accepted events only.
     virtual Bool_t Notify();
     virtual Int_t Cut(Long64_t entryNumber);
 
+    // Merge the results accumulated by another instance of this
+    // class which processed a different part of the input chain.
+    // Used in the multithreaded mode.
+    virtual int mergeResults(RootChainProcessor<RootMadeClass>& other);
+
+    // Process the events still queued for batched channel selection
+    virtual int endEventLoop();
+
+    // Save the managed histograms and ntuples with the checkpoint record
+    virtual int writeCheckpoint(const CheckpointInfo& info);
+
+    // Publish the managed histograms in the streaming mode
+    virtual int writeSnapshot(SnapshotPublisher& publisher);
+
+    // Add the memory of the managed histograms and ntuples
+    virtual void reportMemory(MemoryUsage& usage) const;
+
     // Channel number. Note that calling this method only makes sense
     // after "channelNumber" array has been filled.
     inline unsigned getHBHEChannelNumber(const unsigned pulseNumber) const
@@ -131,20 +154,133 @@ private:
     // The histogram manager
     HistogramManager manager_;
 
+    // Handle of the "HBHE" histogram group, with one entry per channel
+    HistogramManager::GroupHandle hbheGroup_;
+
     // Channel number mapping tool
     HBHEChannelMap channelMap_;
 
     // HCAL geometry tool
     HBHEChannelGeometry channelGeometry_;
 
-    // Channel selector
-    AbsChannelSelector<MyType>* channelSelector_;
+    // Channel selection made with one configuration of the channel
+    // selector. Normally, there is just one configuration. Several
+    // configurations are used in the scan mode.
+    struct SelectionConfig
+    {
+        inline SelectionConfig()
+            : selector(0), jetSelector(0), pattRecoScale(0.0),
+              coneSize(0.0), peakEtCutoff(0.0), jetPtCutoff(0.0) {}
+
+        // Channel selector (owned). This can be a chain of selectors.
+        AbsChannelSelector<MyType>* selector;
+
+        // The FFTJet-based selector if there is one (either the
+        // selector itself or a stage of the chain), otherwise NULL
+        AbsFFTJetChannelSelector<MyType>* jetSelector;
+
+        // Mask to be used for selection of good channels
+        std::vector<unsigned char> mask;
+
+        // Parent object Pt for the channels
+        std::vector<double> parentPt;
+
+        // Summary for the locally reconstructed jets
+        JetSummary jetSummary;
+
+        // Prefix for the output directories (empty or "Scank/")
+        // and the name of the histogram group for jet items
+        std::string directory;
+        std::string jetGroup;
+        HistogramManager::GroupHandle jetGroupHandle;
+
+        // Selector parameters
+        double pattRecoScale;
+        double coneSize;
+        double peakEtCutoff;
+        double jetPtCutoff;
+    };
+
+    // Channel selection configurations. This vector is filled
+    // in the constructor and is not resized afterwards (booked
+    // items refer to the configuration members).
+    std::vector<SelectionConfig> configs_;
+
+    // FFTJet selector working in single precision, for comparing
+    // the results with the first configuration ("--fftPrecision
+    // validate" option). Owned.
+    AbsFFTJetChannelSelector<MyType>* validationSelector_;
+    std::vector<unsigned char> validationMask_;
+    JetListComparison precisionComparison_;
 
-    // Mask to be used for selection of good channels
-    std::vector<unsigned char> channelSelectionMask_;
+    // Cache of FFTJet results ("--fftJetCache" option), shared by all
+    // configurations. Owned, NULL if the cache is not used.
+    FFTJetResultCache* resultCache_;
 
-    // Parent object Pt for the channels
-    std::vector<double> parentObjectPt_;
+    // FFTJet convolutions on a GPU ("--fftBackend" option)
+    bool useCudaFFT_;
+
+    // Events queued for the batched GPU convolutions ("--eventBatch"
+    // option). Without the GPU, the events are processed as they are
+    // read. The queue is processed when it is full, when the input
+    // file changes (see EntryQueue.h), before checkpoints and snapshots,
+    // and at the end of the event loop.
+    friend class EntryQueue<MyType>;
+    EntryQueue<MyType> queue_;
+
+    // Chain entry whose data are in the tree buffers, provided the
+    // event loop has not moved on since (see "loadEntry"), and the
+    // entry for which "prepareEvent" was called last (-1 if none)
+    long long loadedEntry_;
+    long long preparedEntry_;
+
+    // Calculate the channel numbers and charges for the current entry
+    void prepareEvent();
+
+    // Select the channels and fill the histograms for the current entry
+    int processEvent();
+
+    // Pass the current entry, just queued, to the channel selectors
+    // for the batched GPU convolutions (called by "queue_")
+    void entryQueued(long long entry);
+
+    // Submit the batch, then select the channels and fill the
+    // histograms for each of the queued events, in order. Only the
+    // entries which are no longer in the tree buffers are read again.
+    // Called by "queue_".
+    int processQueuedEntries(const std::vector<long long>& entries);
+
+    // Make the given chain entry current again (called by "queue_")
+    inline void reloadEntry(const long long entry) {loadEntry(entry);}
+
+    // Read the given chain entry unless its data are still
+    // in the tree buffers
+    void loadEntry(long long entry);
+
+    // Check whether the channel selector class name is supported
+    static bool isKnownChannelSelector(const std::string& name);
+
+    // Create a channel selector of the given class for the configuration
+    // with the given number. For FFTJet selectors, the "jetSelector"
+    // member of the configuration is set as well.
+    AbsChannelSelector<MyType>* makeChannelSelector(const std::string& name,
+                                                    unsigned iconf);
+
+    // Create an FFTJet selector with the given precision and
+    // parameters. If "jetSource" is not NULL, the new selector
+    // will reuse the jets found by "jetSource".
+    template <typename Real>
+    AbsFFTJetChannelSelector<MyType>* makeFFTJetSelector(
+        const SelectionConfig& config,
+        AbsFFTJetChannelSelector<MyType>* jetSource) const;
+
+    // Description of everything the jet reconstruction of the given
+    // configuration depends upon (hashed to make the cache key)
+    std::string jetRecoDescription(const SelectionConfig& config,
+                                   const char* precision) const;
+
+    // Book histograms and ntuples which depend on the channel selection
+    void bookConfigurationItems(SelectionConfig& config);
 
     // Linearized channel number (index valid up to this->PulseCount)
     unsigned channelNumber_[HBHEChannelMap::ChannelCount];
@@ -152,17 +288,20 @@ private:
     // Charge in this channel (index valid up to this->PulseCount)
     unsigned channelCharge_[HBHEChannelMap::ChannelCount];
 
-    // Summary for the locally reconstructed jets
-    JetSummary jetSummary_;
-
     // Method to fill the jet summary
-    void fillJetSummary(JetSummary* summary);
+    void fillJetSummary(const AbsFFTJetChannelSelector<MyType>* sel,
+                        JetSummary* summary);
 
     // Event counter for this job
     unsigned long eventCounter_;
 
     // Channel counter for this job
     unsigned long channelCounter_;
+
+    // Timed stages (see RootChainProcessor::enableTiming)
+    unsigned selectStage_;
+    unsigned fillStage_;
+    unsigned batchStage_;
 };
 
 #include "SelectGoodChannels.icc"
@@ -1,10 +1,16 @@
 #ifndef SelectGoodChannelsOptions_h_
 #define SelectGoodChannelsOptions_h_
 
+#include <string>
+#include <vector>
+#include <sstream>
 #include <iostream>
+#include <stdexcept>
 
 #include "CmdLine.hh"
 #include "inputValidation.hh"
+#include "fftwWisdom.h"
+#include "convertCSVIntoVector.h"
 
 //
 // Class SelectGoodChannelsOptions must have
@@ -21,8 +27,9 @@
 // 5) Method "void usage(std::ostream& os) const" for printing usage
 //    instructions
 //
-// Preferably, this class should also have "operator<<" for printing
-// the option values actually used.
+// This class must also have "operator<<" for printing the option
+// values actually used (the main program stores this printout in
+// the output file, see JobInfo.h).
 //
 // This class works in tandem with the analysis class.
 // SelectGoodChannelsOptions object is a "const" member in the analysis
@@ -36,11 +43,17 @@
 //
 // Do not use here switches reserved for use by the main program.
 // These switches are:
+//   "-a", "--asyncPrefetch"
+//   "-b", "--branches"
+//   "-c", "--cacheSize"
 //   "-h", "--histogram"
+//   "-j", "--threads"
 //   "-n", "--maxEvents"
 //   "-s", "--noStats"
 //   "-t", "--treeName"
+//   "-u", "--parallelUnzip"
 //   "-v", "--verbose"
+//   "--firstEvent", "--shard", "--fileShard", "--timing"
 //
 struct SelectGoodChannelsOptions
 {
@@ -48,40 +61,139 @@ struct SelectGoodChannelsOptions
         : hbGeometryFile("Geometry/hb.ctr"),
           heGeometryFile("Geometry/he.ctr"),
           channelSelector("FFTJetChannelSelector"),
-          pattRecoScale(0.2),
+          fftPlanner("estimate"),
+          fftPrecision("double"),
+          fftBackend("cpu"),
+          eventBatch(0),
+          pattRecoScales(1, 0.2),
           etaToPhiBandwidthRatio(1.0),
-          coneSize(0.5),
-          peakEtCutoff(5.0),
-          jetPtCutoff(20.0),
+          coneSizes(1, 0.5),
+          peakEtCutoffs(1, 5.0),
+          jetPtCutoffs(1, 20.0),
           minRecHitTime(-1.0e30),
           maxRecHitTime(1.0e30),
           etFractionCutoff(0.02),
+          noiseHitEnergy(1.5),
+          noiseIsolatedHPDEnergy(50.0),
+          noiseNeighborFraction(0.1),
+          pulseShifts(defaultPulseShifts()),
+          pulseTemplate(defaultPulseTemplate()),
+          pulseNoise(1.0),
+          pulseRelativeError(0.1),
+          pulseMaxChi2(10.0),
+          pulseMinCharge(20.0),
+          minChannelEnergy(0.0),
+          minPulseTime(3.0),
+          maxPulseTime(6.0),
+          skimQuantum(0.0),
           minResponseTS(3),
-          maxResponseTS(8)
+          maxResponseTS(8),
+          nEtaBins(256),
+          nPhiBins(128),
+          noiseHPDHits(17),
+          noiseRBXHits(50),
+          minBunch(-1),
+          maxBunch(-1)
     {
     }
 
     void parse(CmdLine& cmdline)
     {
         storeSelectedOnly = cmdline.has(NULL, "--storeSelectedOnly");
+        skimAllChannels = cmdline.has(NULL, "--skimAllChannels");
+        skimSinglePrecision = cmdline.has(NULL, "--skimSinglePrecision");
         cmdline.option(NULL, "--hbgeo") >> hbGeometryFile;
         cmdline.option(NULL, "--hegeo") >> heGeometryFile;
         cmdline.option(NULL, "--channelSelector") >> channelSelector;
+        cmdline.option(NULL, "--fftWisdom") >> fftWisdomFile;
+        cmdline.option(NULL, "--fftPlanner") >> fftPlanner;
+        cmdline.option(NULL, "--fftPrecision") >> fftPrecision;
+        cmdline.option(NULL, "--fftJetCache") >> fftJetCache;
+        cmdline.option(NULL, "--fftBackend") >> fftBackend;
+        cmdline.option(NULL, "--eventBatch") >> eventBatch;
+        cmdline.option(NULL, "--nEtaBins") >> nEtaBins;
+        cmdline.option(NULL, "--nPhiBins") >> nPhiBins;
 
-        cmdline.option(NULL, "--pattRecoScale") >> pattRecoScale;
+        parseList(cmdline, "--pattRecoScale", &pattRecoScales);
         cmdline.option(NULL, "--etaToPhiBandwidthRatio") >> etaToPhiBandwidthRatio;
-        cmdline.option(NULL, "--coneSize") >> coneSize;
-        cmdline.option(NULL, "--peakEtCutoff") >> peakEtCutoff;
-        cmdline.option(NULL, "--jetPtCutoff") >> jetPtCutoff;
+        parseList(cmdline, "--coneSize", &coneSizes);
+        parseList(cmdline, "--peakEtCutoff", &peakEtCutoffs);
+        parseList(cmdline, "--jetPtCutoff", &jetPtCutoffs);
         cmdline.option(NULL, "--etFractionCutoff") >> etFractionCutoff;
         cmdline.option(NULL, "--minRecHitTime") >> minRecHitTime;
         cmdline.option(NULL, "--maxRecHitTime") >> maxRecHitTime;
 
+        cmdline.option(NULL, "--noiseHitEnergy") >> noiseHitEnergy;
+        cmdline.option(NULL, "--noiseHPDHits") >> noiseHPDHits;
+        cmdline.option(NULL, "--noiseRBXHits") >> noiseRBXHits;
+        cmdline.option(NULL, "--noiseIsolatedHPDEnergy") >> noiseIsolatedHPDEnergy;
+        cmdline.option(NULL, "--noiseNeighborFraction") >> noiseNeighborFraction;
+
+        parseList(cmdline, "--pulseTemplate", &pulseTemplate);
+        {
+            std::string shifts;
+            cmdline.option(NULL, "--pulseShifts") >> shifts;
+            if (!shifts.empty())
+                pulseShifts = convertCSVIntoVector<int>(shifts, "pulseShifts");
+        }
+        cmdline.option(NULL, "--pulseNoise") >> pulseNoise;
+        cmdline.option(NULL, "--pulseRelativeError") >> pulseRelativeError;
+        cmdline.option(NULL, "--pulseMaxChi2") >> pulseMaxChi2;
+        cmdline.option(NULL, "--pulseMinCharge") >> pulseMinCharge;
+
+        cmdline.option(NULL, "--minChannelEnergy") >> minChannelEnergy;
+        cmdline.option(NULL, "--minPulseTime") >> minPulseTime;
+        cmdline.option(NULL, "--maxPulseTime") >> maxPulseTime;
+
         cmdline.option(NULL, "--minResponseTS") >> minResponseTS;
         cmdline.option(NULL, "--maxResponseTS") >> maxResponseTS;
+        cmdline.option(NULL, "--skimQuantum") >> skimQuantum;
+        cmdline.option(NULL, "--minBunch") >> minBunch;
+        cmdline.option(NULL, "--maxBunch") >> maxBunch;
 
         validateRangeLELT(minResponseTS, "minResponseTS", 0U, 9U);
         validateRangeLELT(maxResponseTS, "maxResponseTS", minResponseTS+1U, 10U);
+        validateRangeLELT(nEtaBins, "nEtaBins", 1U, 65537U);
+        validateRangeLELT(nPhiBins, "nPhiBins", 1U, 65537U);
+        validateRangeLELT(noiseHPDHits, "noiseHPDHits", 1U, 19U);
+        validateRangeLELT(noiseRBXHits, "noiseRBXHits", 1U, 73U);
+
+        if (minBunch >= 0 && maxBunch >= 0 && maxBunch < minBunch)
+            throw std::invalid_argument("Maximum bunch number can not be "
+                                        "smaller than the minimum");
+        if (skimQuantum < 0.0)
+            throw std::invalid_argument("Skim quantum can not be negative");
+        if (pulseTemplate.size() != 10U)
+            throw std::invalid_argument("Pulse template must have 10 values");
+        if (pulseShifts.size() > 4U)
+            throw std::invalid_argument("At most 4 pulse shifts are supported");
+        if (!(pulseNoise > 0.0 && pulseRelativeError >= 0.0 &&
+              pulseMaxChi2 > 0.0))
+            throw std::invalid_argument("Pulse noise and chi-square cutoff "
+                                        "must be positive, relative error "
+                                        "must be non-negative");
+
+        // This will throw std::invalid_argument for unknown rigor names
+        fftwPlannerFlag(fftPlanner);
+
+        for (unsigned i=0; i<pattRecoScales.size(); ++i)
+            if (!(pattRecoScales[i] > 0.0))
+                throw std::invalid_argument("Pattern recognition scales "
+                                            "must be positive");
+        for (unsigned i=0; i<coneSizes.size(); ++i)
+            if (!(coneSizes[i] > 0.0))
+                throw std::invalid_argument("Cone sizes must be positive");
+
+        if (!(fftPrecision == "double" || fftPrecision == "float" ||
+              fftPrecision == "validate"))
+            throw std::invalid_argument("Invalid value of the --fftPrecision "
+                                        "option: must be \"double\", "
+                                        "\"float\", or \"validate\"");
+        if (!(fftBackend == "cpu" || fftBackend == "cuda" ||
+              fftBackend == "auto"))
+            throw std::invalid_argument("Invalid value of the --fftBackend "
+                                        "option: must be \"cpu\", "
+                                        "\"cuda\", or \"auto\"");
     }
 
     void listOptions(std::ostream& os) const
@@ -90,16 +202,43 @@ struct SelectGoodChannelsOptions
            << " [--hbgeo filename]"
            << " [--hegeo filename]"
            << " [--channelSelector classname]"
-           << " [--pattRecoScale value]"
+           << " [--fftWisdom filename]"
+           << " [--fftPlanner rigor]"
+           << " [--fftPrecision precision]"
+           << " [--fftJetCache filename]"
+           << " [--fftBackend device]"
+           << " [--eventBatch value]"
+           << " [--nEtaBins value]"
+           << " [--nPhiBins value]"
+           << " [--pattRecoScale values]"
            << " [--etaToPhiBandwidthRatio value]"
-           << " [--coneSize value]"
-           << " [--peakEtCutoff value]"
-           << " [--jetPtCutoff value]"
+           << " [--coneSize values]"
+           << " [--peakEtCutoff values]"
+           << " [--jetPtCutoff values]"
            << " [--etFractionCutoff value]"
+           << " [--noiseHitEnergy value]"
+           << " [--noiseHPDHits value]"
+           << " [--noiseRBXHits value]"
+           << " [--noiseIsolatedHPDEnergy value]"
+           << " [--noiseNeighborFraction value]"
+           << " [--pulseTemplate values]"
+           << " [--pulseShifts values]"
+           << " [--pulseNoise value]"
+           << " [--pulseRelativeError value]"
+           << " [--pulseMaxChi2 value]"
+           << " [--pulseMinCharge value]"
+           << " [--minChannelEnergy value]"
+           << " [--minPulseTime value]"
+           << " [--maxPulseTime value]"
            << " [--minRecHitTime value]"
            << " [--maxRecHitTime value]"
            << " [--minResponseTS value]"
            << " [--maxResponseTS value]"
+           << " [--skimAllChannels]"
+           << " [--skimSinglePrecision]"
+           << " [--skimQuantum value]"
+           << " [--minBunch value]"
+           << " [--maxBunch value]"
             ;
     }
 
@@ -116,9 +255,66 @@ struct SelectGoodChannelsOptions
            << "                     some directory other than the source directory),\n"
            << "                     correct value of this option must be provided.\n\n";
         os << " --channelSelector   Class to use for selecting good channels. Valid\n"
-              "                     values of this option are \"FFTJetChannelSelector\"\n"
-              "                     and \"AllChannelSelector\". Default is\n"
-              "                     \"FFTJetChannelSelector\".\n\n";
+              "                     values of this option are \"FFTJetChannelSelector\",\n"
+              "                     \"HPDNoiseChannelSelector\", \"PulseShapeChannelSelector\",\n"
+              "                     \"EnergyCutChannelSelector\", \"PulseTimeChannelSelector\",\n"
+              "                     and \"AllChannelSelector\". A comma-separated list of\n"
+              "                     classes makes a chain of selectors in which every\n"
+              "                     selector sees only the channels kept by the preceding\n"
+              "                     ones, so cheap cuts should come first. For example,\n"
+              "                     \"EnergyCutChannelSelector,FFTJetChannelSelector\".\n"
+              "                     FFTJet still uses all channels for jet reconstruction.\n"
+              "                     Default is \"FFTJetChannelSelector\".\n\n";
+        os << " --fftWisdom         File for keeping FFTW wisdom. If this file exists, the\n"
+           << "                     wisdom is loaded from it before the DFFT plans are made.\n"
+           << "                     If new wisdom is accumulated while making the plans,\n"
+           << "                     the file is (re)written. Use together with --fftPlanner\n"
+           << "                     to avoid repeating expensive planning in each job. By\n"
+           << "                     default, wisdom is neither loaded nor saved.\n\n";
+        os << " --fftPlanner        FFTW planner rigor: \"estimate\", \"measure\", \"patient\",\n"
+           << "                     or \"exhaustive\". Default is \"estimate\".\n\n";
+        os << " --fftPrecision      Precision of the FFTJet energy flow grid and DFFTs:\n"
+           << "                     \"double\" or \"float\". With \"validate\", the channels\n"
+           << "                     are selected in double precision while FFTJet is also\n"
+           << "                     run in single precision, and the differences between\n"
+           << "                     the two sets of jets and channel masks are printed at\n"
+           << "                     the end of the job. Default is \"double\". Single\n"
+           << "                     precision FFTW wisdom is kept in the --fftWisdom file\n"
+           << "                     name with \".float\" appended. The validation is\n"
+           << "                     performed only when FFTJetChannelSelector is not\n"
+           << "                     chained with other selectors.\n\n";
+        os << " --fftJetCache       File for keeping the jets reconstructed by FFTJet,\n"
+           << "                     keyed by run, event, and the jet reconstruction\n"
+           << "                     parameters. The jets found in this file are not\n"
+           << "                     reconstructed again, and the new jets are added to\n"
+           << "                     the file. The channels are always associated with\n"
+           << "                     the jets anew, so --jetPtCutoff, --etFractionCutoff,\n"
+           << "                     and the selector chain can be changed without losing\n"
+           << "                     the cached results. Jobs running at the same time\n"
+           << "                     must not share the file. By default, no cache is used.\n\n";
+        os << " --fftBackend        Device for the FFTJet pattern recognition convolutions:\n"
+           << "                     \"cpu\", \"cuda\", or \"auto\" (the GPU if there is one,\n"
+           << "                     otherwise the CPU). With a GPU, the energy flow grids of\n"
+           << "                     --eventBatch events are convolved together in one pass\n"
+           << "                     (the CPU waits for the results). The jets can\n"
+           << "                     differ from the CPU ones by rounding. The GPU support is\n"
+           << "                     compiled in by \"make cuda\". Default is \"cpu\".\n\n";
+        os << " --eventBatch        Number of events queued for the GPU convolutions and\n"
+           << "                     passed to the channel selectors together (the queue\n"
+           << "                     never spans input files). Value of 0 (default) means\n"
+           << "                     32. Without the GPU, the events are not queued.\n\n";
+        os << " --nEtaBins          Number of eta bins in the FFTJet energy discretization\n"
+           << "                     grid. Default is 256.\n\n";
+        os << " --nPhiBins          Number of phi bins in the FFTJet energy discretization\n"
+           << "                     grid. Default is 128.\n\n";
+        os << " Options --pattRecoScale, --coneSize, --peakEtCutoff, and --jetPtCutoff\n"
+           << " accept comma-separated lists of values. If a list has more than one\n"
+           << " value, the program runs in the scan mode: channels are selected for\n"
+           << " every combination of the values, and the jet and channel items for\n"
+           << " configuration k are placed into the directory \"Scank\" of the output\n"
+           << " file. The configurations are described by the \"ScanConfigurations\"\n"
+           << " ntuple. Jet reconstruction is performed once for the configurations\n"
+           << " which differ only by --jetPtCutoff.\n\n";
         os << " --pattRecoScale     Pattern recognition scale for FFTJet jet reconstruction.\n"
            << "                     Default value is 0.2.\n\n";
         os << " --etaToPhiBandwidthRatio   Eta/phi pattern recognition bandwidth ratio and\n"
@@ -131,52 +327,209 @@ struct SelectGoodChannelsOptions
            << "                     value is 20.0.\n\n";
         os << " --etFractionCutoff  Fraction of jet Et left out by the channels included into\n"
            << "                     the analysis. Default is 0.02\n\n";
+        os << " Options --noiseHitEnergy, --noiseHPDHits, --noiseRBXHits,\n"
+           << " --noiseIsolatedHPDEnergy, and --noiseNeighborFraction configure\n"
+           << " HPDNoiseChannelSelector. It drops all channels of an HPD if the HPD\n"
+           << " has too many hits, if its RBX has too many hits, or if the HPD is\n"
+           << " energetic but isolated from its neighbors in other HPDs.\n\n";
+        os << " --noiseHitEnergy    Minimum channel energy counted as a hit. Default is 1.5.\n\n";
+        os << " --noiseHPDHits      Minimum number of hits in a noisy HPD. Default is 17.\n\n";
+        os << " --noiseRBXHits      Minimum number of hits in a noisy RBX. Default is 50.\n\n";
+        os << " --noiseIsolatedHPDEnergy   Minimum energy of an isolated noisy HPD. Default\n"
+           << "                            value is 50.0.\n\n";
+        os << " --noiseNeighborFraction    Maximum ratio of the energy in the neighboring\n"
+           << "                            channels from other HPDs to the HPD energy for\n"
+           << "                            an isolated HPD. Default value is 0.1.\n\n";
+        os << " Options --pulseTemplate, --pulseShifts, --pulseNoise, --pulseRelativeError,\n"
+           << " --pulseMaxChi2, and --pulseMinCharge configure PulseShapeChannelSelector.\n"
+           << " It fits the pedestal-subtracted charges in the time slices from\n"
+           << " --minResponseTS to --maxResponseTS by the shifted pulse template and\n"
+           << " drops the channels with bad chi-square.\n\n";
+        os << " --pulseTemplate     Comma-separated pulse shape, 10 values (one per time\n"
+           << "                     slice). Normalized internally. Default is\n"
+           << "                     \"0,0,0,0.02,0.7,0.2,0.06,0.02,0,0\".\n\n";
+        os << " --pulseShifts       Comma-separated time slice shifts of the template\n"
+           << "                     to try (up to 4). Default is \"0,1\".\n\n";
+        os << " --pulseNoise        Charge noise in fC per time slice. Default is 1.0.\n\n";
+        os << " --pulseRelativeError   Relative charge uncertainty per time slice. Default\n"
+           << "                        value is 0.1.\n\n";
+        os << " --pulseMaxChi2      Maximum chi-square per degree of freedom. Default\n"
+           << "                     is 10.0.\n\n";
+        os << " --pulseMinCharge    Channels with smaller charge (in fC, summed over the\n"
+           << "                     fitted time slices) are kept without fitting.\n"
+           << "                     Default is 20.0.\n\n";
+        os << " --minChannelEnergy  Minimum channel energy for EnergyCutChannelSelector.\n"
+           << "                     Default is 0.0.\n\n";
+        os << " --minPulseTime      Minimum (included) and maximum (excluded) pulse time\n"
+           << " --maxPulseTime      for PulseTimeChannelSelector. The pulse time is the\n"
+           << "                     charge-weighted mean time slice number calculated\n"
+           << "                     from --minResponseTS to --maxResponseTS. Defaults\n"
+           << "                     are 3.0 and 6.0.\n\n";
         os << " --minRecHitTime     Minimum RecHitTime for \"good\" channels. This option\n"
            << "                     is currently unused.\n\n";
         os << " --maxRecHitTime     Maximum RecHitTime for \"good\" channels. This option\n"
            << "                     is currently unused.\n\n";
+        os << " --minBunch          Minimum and maximum (both included) bunch crossing\n"
+           << " --maxBunch          numbers of the processed events. Negative values\n"
+           << "                     (default) mean no limit. The cut reads only the\n"
+           << "                     \"Bunch\" branch, so the other branches are not read\n"
+           << "                     for the rejected events.\n\n";
         os << " --minResponseTS     Minimum time slice (included) for defining the \"real\"\n"
            << "                     signal charge. Default is 3.\n\n";
         os << " --maxResponseTS     Maximum time slice (excluded) for defining the \"real\"\n"
            << "                     signal charge. Default is 8.\n\n";
         os << " --storeSelectedOnly    Store only the channels chosen by the channel selector.\n"
            << "                        Can be used to reduce the channel ntuple size.\n\n";
+        os << " Options --skimAllChannels, --skimSinglePrecision, and --skimQuantum\n"
+           << " configure the skim of the input tree written when \"SkimTree\" is requested\n"
+           << " with -h. The skim is the tree \"Skim/HcalTree\" in the output file. It has\n"
+           << " the schema of the input tree and contains the channels selected by the\n"
+           << " (first configuration of the) channel selector in the events with at least\n"
+           << " one selected channel. Process it with \"-t Skim/HcalTree\".\n\n";
+        os << " --skimAllChannels   Write all channels of the events which pass \"Cut\".\n\n";
+        os << " --skimSinglePrecision  Store the time slice charges, pedestals, and gains\n"
+           << "                        in single precision (Double32_t).\n\n";
+        os << " --skimQuantum       Round the time slice charges and pedestals in the skim\n"
+           << "                     to multiples of this value (in fC). Default is 0 (no\n"
+           << "                     rounding).\n\n";
     }
 
     std::string hbGeometryFile;
     std::string heGeometryFile;
     std::string channelSelector;
+    std::string fftWisdomFile;
+    std::string fftPlanner;
+    std::string fftPrecision;
+    std::string fftJetCache;
+    std::string fftBackend;
+    unsigned eventBatch;
 
-    double pattRecoScale;
+    std::vector<double> pattRecoScales;
     double etaToPhiBandwidthRatio;
-    double coneSize;
-    double peakEtCutoff;
-    double jetPtCutoff;
+    std::vector<double> coneSizes;
+    std::vector<double> peakEtCutoffs;
+    std::vector<double> jetPtCutoffs;
     double minRecHitTime;
     double maxRecHitTime;
     double etFractionCutoff;
+    double noiseHitEnergy;
+    double noiseIsolatedHPDEnergy;
+    double noiseNeighborFraction;
+    std::vector<int> pulseShifts;
+    std::vector<double> pulseTemplate;
+    double pulseNoise;
+    double pulseRelativeError;
+    double pulseMaxChi2;
+    double pulseMinCharge;
+    double minChannelEnergy;
+    double minPulseTime;
+    double maxPulseTime;
+    double skimQuantum;
 
     unsigned minResponseTS;
     unsigned maxResponseTS;
+    unsigned nEtaBins;
+    unsigned nPhiBins;
+    unsigned noiseHPDHits;
+    unsigned noiseRBXHits;
+    int minBunch;
+    int maxBunch;
     bool storeSelectedOnly;
+    bool skimAllChannels;
+    bool skimSinglePrecision;
+
+    // Number of channel selection configurations
+    inline unsigned nConfigurations() const
+    {
+        return pattRecoScales.size()*coneSizes.size()*
+               peakEtCutoffs.size()*jetPtCutoffs.size();
+    }
+
+    // Comma-separated representation of a list of values
+    template <typename T>
+    static std::string listString(const std::vector<T>& v)
+    {
+        std::ostringstream os;
+        const unsigned n = v.size();
+        for (unsigned i=0; i<n; ++i)
+        {
+            if (i) os << ',';
+            os << v[i];
+        }
+        return os.str();
+    }
+
+    // Default pulse shape, peaking in time slice 4
+    static std::vector<double> defaultPulseTemplate()
+    {
+        static const double t[10] = {0.0, 0.0, 0.0, 0.02, 0.70,
+                                     0.20, 0.06, 0.02, 0.0, 0.0};
+        return std::vector<double>(t, t + 10);
+    }
+
+    static std::vector<int> defaultPulseShifts()
+    {
+        std::vector<int> shifts;
+        shifts.push_back(0);
+        shifts.push_back(1);
+        return shifts;
+    }
+
+private:
+    static void parseList(CmdLine& cmdline, const char* option,
+                          std::vector<double>* values)
+    {
+        std::string s;
+        cmdline.option(NULL, option) >> s;
+        if (!s.empty())
+            *values = convertCSVIntoVector<double>(s, option + 2);
+    }
 };
 
+
 std::ostream& operator<<(std::ostream& os, const SelectGoodChannelsOptions& o)
 {
     os << ", hbgeo = \"" << o.hbGeometryFile << '"'
        << ", hegeo = \"" << o.heGeometryFile << '"'
        << ", channelSelector = \"" << o.channelSelector << '"'
-       << ", pattRecoScale = \"" << o.pattRecoScale << '"'
+       << ", fftWisdom = \"" << o.fftWisdomFile << '"'
+       << ", fftPlanner = \"" << o.fftPlanner << '"'
+       << ", fftPrecision = \"" << o.fftPrecision << '"'
+       << ", fftJetCache = \"" << o.fftJetCache << '"'
+       << ", fftBackend = \"" << o.fftBackend << '"'
+       << ", eventBatch = " << o.eventBatch
+       << ", nEtaBins = " << o.nEtaBins
+       << ", nPhiBins = " << o.nPhiBins
+       << ", pattRecoScale = \"" << o.listString(o.pattRecoScales) << '"'
        << ", etaToPhiBandwidthRatio = \"" << o.etaToPhiBandwidthRatio << '"'
-       << ", coneSize = \"" << o.coneSize << '"'
-       << ", peakEtCutoff = \"" << o.peakEtCutoff << '"'
-       << ", jetPtCutoff = \"" << o.jetPtCutoff << '"'
+       << ", coneSize = \"" << o.listString(o.coneSizes) << '"'
+       << ", peakEtCutoff = \"" << o.listString(o.peakEtCutoffs) << '"'
+       << ", jetPtCutoff = \"" << o.listString(o.jetPtCutoffs) << '"'
        << ", minRecHitTime = \"" << o.minRecHitTime << '"'
        << ", maxRecHitTime = \"" << o.maxRecHitTime << '"'
        << ", etFractionCutoff = \"" << o.etFractionCutoff << '"'
+       << ", noiseHitEnergy = " << o.noiseHitEnergy
+       << ", noiseHPDHits = " << o.noiseHPDHits
+       << ", noiseRBXHits = " << o.noiseRBXHits
+       << ", noiseIsolatedHPDEnergy = " << o.noiseIsolatedHPDEnergy
+       << ", noiseNeighborFraction = " << o.noiseNeighborFraction
+       << ", pulseTemplate = \"" << o.listString(o.pulseTemplate) << '"'
+       << ", pulseShifts = \"" << o.listString(o.pulseShifts) << '"'
+       << ", pulseNoise = " << o.pulseNoise
+       << ", pulseRelativeError = " << o.pulseRelativeError
+       << ", pulseMaxChi2 = " << o.pulseMaxChi2
+       << ", pulseMinCharge = " << o.pulseMinCharge
+       << ", minChannelEnergy = " << o.minChannelEnergy
+       << ", minPulseTime = " << o.minPulseTime
+       << ", maxPulseTime = " << o.maxPulseTime
        << ", minResponseTS = " << o.minResponseTS
        << ", maxResponseTS = " << o.maxResponseTS
        << ", storeSelectedOnly = " << o.storeSelectedOnly
+       << ", skimAllChannels = " << o.skimAllChannels
+       << ", skimSinglePrecision = " << o.skimSinglePrecision
+       << ", skimQuantum = " << o.skimQuantum
+       << ", minBunch = " << o.minBunch
+       << ", maxBunch = " << o.maxBunch
         ;
     return os;
 }
@@ -0,0 +1,252 @@
+#ifndef SharedHisto_h_
+#define SharedHisto_h_
+
+//
+// Histogram bins shared by all workers of the multithreaded mode
+// (see "processChainInParallel.h"). Instead of filling its own copy
+// of every histogram and merging the copies at the end of the job,
+// each worker adds its fills directly to a single flat array of bin
+// contents using relaxed atomic additions. This saves the memory of
+// the per-thread copies of large TH2D/TH3D histograms and the time
+// needed to merge them.
+//
+// The sharing is set up by HistogramManager (see its "shareHistograms"
+// method): when a histogram wrapper is managed, it attaches itself to
+// the SharedHistoBins object made for the histogram name and directory
+// by the store, via a SharedHistoFiller. The root histograms of all
+// workers except the owner (worker 0) are then shrunk to a single bin
+// per axis. When all event loops are finished, "materialize" writes
+// the shared contents, the sums of squared weights, the statistics,
+// and the numbers of entries into the root histograms of the owner,
+// before its "endJob" is called.
+//
+// The bin statistics (sums of weights times coordinates) and the
+// numbers of entries are accumulated by every filler separately, so
+// that the atomic operations are needed for the bin contents only.
+// Since the order of floating point additions depends on the thread
+// scheduling, the bin contents of histograms filled with non-integer
+// weights may differ between runs in the last few bits.
+//
+// Only histograms with uniform binning (as made by the AutoH*D and
+// CycledH*D functions) can be shared.
+//
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+
+class TH1;
+class SharedHistoFiller;
+
+class SharedHistoBins
+{
+public:
+    // The binning is taken from the prototype
+    explicit SharedHistoBins(const TH1& prototype);
+
+    inline unsigned dim() const {return dim_;}
+    inline unsigned nCells() const {return sums_.size()/2U;}
+
+    // Bin number along an axis in the root convention
+    // (0 is the underflow, nbins + 1 is the overflow)
+    inline unsigned axisBin(const unsigned iaxis, const double x) const
+    {
+        const Axis& a(axes_[iaxis]);
+        if (x < a.xmin)
+            return 0U;
+        else if (!(x < a.xmax))
+            return a.nbins + 1U;
+        else
+            return 1U + static_cast<unsigned>(a.nbins*(x - a.xmin)/a.width);
+    }
+
+    inline bool inRange(const unsigned iaxis, const unsigned bin) const
+        {return bin && bin <= axes_[iaxis].nbins;}
+
+    // Global cell number in the root convention
+    inline unsigned cell(const unsigned bx, const unsigned by=0U,
+                         const unsigned bz=0U) const
+        {return bx + (axes_[0].nbins + 2U)*(by + (axes_[1].nbins + 2U)*bz);}
+
+    inline void add(const unsigned icell, const double w)
+    {
+        atomicAdd(&sums_[2U*icell], w);
+        atomicAdd(&sums_[2U*icell + 1U], w*w);
+    }
+
+    // Check that the histogram has the same binning
+    bool isCompatible(const TH1& h) const;
+
+private:
+    friend class SharedHistoFiller;
+    friend class SharedHistoStore;
+
+    struct Axis
+    {
+        inline Axis() : nbins(0), xmin(0.0), xmax(1.0), width(1.0) {}
+
+        unsigned nbins;
+        double xmin;
+        double xmax;
+        double width;
+    };
+
+    static inline void atomicAdd(std::atomic<double>* a, const double w)
+    {
+        double old = a->load(std::memory_order_relaxed);
+        while (!a->compare_exchange_weak(old, old + w,
+                                         std::memory_order_relaxed)) {}
+    }
+
+    void attach(SharedHistoFiller* f);
+    void detach(SharedHistoFiller* f);
+    void materialize(TH1* h);
+
+    unsigned dim_;
+    Axis axes_[3];
+
+    // Bin contents and sums of squared weights, interleaved
+    std::vector<std::atomic<double> > sums_;
+
+    // Owner histogram which receives the contents
+    TH1* target_;
+
+    // Live fillers and the accumulated state of the detached ones
+    std::mutex mutex_;
+    std::vector<SharedHistoFiller*> fillers_;
+    double stats_[11];
+    double entries_;
+    bool nonUnitWeights_;
+};
+
+
+class SharedHistoStore
+{
+public:
+    inline SharedHistoStore() {}
+    ~SharedHistoStore();
+
+    // Bins for the histogram with the given directory and name, created
+    // from "h" if necessary. "h" becomes the target of "materialize" if
+    // "owner" is true. Throws std::invalid_argument if the histogram
+    // is incompatible with the bins already made for this name.
+    SharedHistoBins* bins(TH1* h, const std::string& directory, bool owner);
+
+    // Write the shared contents into the owner histograms. Throws
+    // std::runtime_error if some histogram has no owner.
+    void materialize();
+
+    inline unsigned size() const {return bins_.size();}
+
+private:
+    SharedHistoStore(const SharedHistoStore&);
+    SharedHistoStore& operator=(const SharedHistoStore&);
+
+    std::mutex mutex_;
+    std::map<std::string,SharedHistoBins*> bins_;
+};
+
+
+// Per-wrapper state of a shared histogram. The fill methods mirror
+// the corresponding TH1/TH2/TH3 "Fill" methods.
+class SharedHistoFiller
+{
+public:
+    // Non-owner histograms are shrunk to one bin per axis
+    SharedHistoFiller(SharedHistoStore& store, TH1* h,
+                      const std::string& directory, bool owner);
+    ~SharedHistoFiller();
+
+    inline void fill(const double x, const double w)
+    {
+        const unsigned bx = bins_->axisBin(0, x);
+        count(w);
+        if (w)
+            bins_->add(bx, w);
+        if (bins_->inRange(0, bx))
+        {
+            stats_[0] += w;
+            stats_[1] += w*w;
+            stats_[2] += w*x;
+            stats_[3] += w*x*x;
+        }
+    }
+
+    inline void fill(const double x, const double y, const double w)
+    {
+        const unsigned bx = bins_->axisBin(0, x);
+        const unsigned by = bins_->axisBin(1, y);
+        count(w);
+        if (w)
+            bins_->add(bins_->cell(bx, by), w);
+        if (bins_->inRange(0, bx) && bins_->inRange(1, by))
+        {
+            stats_[0] += w;
+            stats_[1] += w*w;
+            stats_[2] += w*x;
+            stats_[3] += w*x*x;
+            stats_[4] += w*y;
+            stats_[5] += w*y*y;
+            stats_[6] += w*x*y;
+        }
+    }
+
+    inline void fill(const double x, const double y, const double z,
+                     const double w)
+    {
+        const unsigned bx = bins_->axisBin(0, x);
+        const unsigned by = bins_->axisBin(1, y);
+        const unsigned bz = bins_->axisBin(2, z);
+        count(w);
+        if (w)
+            bins_->add(bins_->cell(bx, by, bz), w);
+        if (bins_->inRange(0, bx) && bins_->inRange(1, by) &&
+            bins_->inRange(2, bz))
+        {
+            stats_[0] += w;
+            stats_[1] += w*w;
+            stats_[2] += w*x;
+            stats_[3] += w*x*x;
+            stats_[4] += w*y;
+            stats_[5] += w*y*y;
+            stats_[6] += w*x*y;
+            stats_[7] += w*z;
+            stats_[8] += w*z*z;
+            stats_[9] += w*x*z;
+            stats_[10] += w*y*z;
+        }
+    }
+
+    // Counterpart of "recordZeroWeightFills"
+    inline void recordZeroWeightFills(const unsigned nSkipped)
+    {
+        if (nSkipped)
+        {
+            entries_ += nSkipped;
+            nonUnitWeights_ = true;
+        }
+    }
+
+private:
+    friend class SharedHistoBins;
+
+    SharedHistoFiller();
+    SharedHistoFiller(const SharedHistoFiller&);
+    SharedHistoFiller& operator=(const SharedHistoFiller&);
+
+    inline void count(const double w)
+    {
+        entries_ += 1.0;
+        if (w != 1.0)
+            nonUnitWeights_ = true;
+    }
+
+    SharedHistoBins* bins_;
+    double stats_[11];
+    double entries_;
+    bool nonUnitWeights_;
+};
+
+#endif // SharedHisto_h_
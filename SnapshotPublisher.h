@@ -0,0 +1,70 @@
+#ifndef SnapshotPublisher_h_
+#define SnapshotPublisher_h_
+
+//
+// Publisher of the managed histograms for online monitoring (see the
+// streaming mode of RootChainProcessor and HistogramManager::publish).
+//
+// A snapshot can be written into a separate root file which is replaced
+// atomically every time, so that the monitoring tools opening the file
+// never see a partially written snapshot. The histograms can also be
+// made available via THttpServer (if the framework is compiled with
+// USE_THTTPSERVER defined, see the Makefile). The server accesses the
+// live histograms, but only from "processRequests", so the event loop
+// should call this method frequently (the streaming loop does this
+// between the events and while it waits for input).
+//
+// Only histograms are published, ntuples stay in the main output file.
+//
+
+#include <set>
+#include <string>
+#include <vector>
+#include <utility>
+
+class TObject;
+class THttpServer;
+
+class SnapshotPublisher
+{
+public:
+    // "snapshotFile" is the name of the file to write the snapshots
+    // into (empty for no file). "httpEngine" is the THttpServer engine
+    // specification, e.g. "http:8080" (empty for no server). Throws
+    // std::invalid_argument if the server is requested but not
+    // supported by this build.
+    SnapshotPublisher(const std::string& snapshotFile,
+                      const std::string& httpEngine);
+
+    ~SnapshotPublisher();
+
+    inline const std::string& snapshotFile() const {return snapshotFile_;}
+    inline bool hasServer() const {return server_;}
+
+    // Items of the next snapshot. "directory" is the directory of the
+    // item in the main output file. The items are not owned.
+    void clear();
+    void add(const std::string& directory, TObject* item);
+
+    // Write the snapshot file and register the new items with the
+    // server. Throws std::runtime_error if the file can not be written.
+    void publish();
+
+    // Serve the pending requests of the http server, if any
+    void processRequests();
+
+    inline unsigned long nPublished() const {return nPublished_;}
+
+private:
+    SnapshotPublisher();
+    SnapshotPublisher(const SnapshotPublisher&);
+    SnapshotPublisher& operator=(const SnapshotPublisher&);
+
+    std::string snapshotFile_;
+    std::vector<std::pair<std::string,TObject*> > items_;
+    std::set<TObject*> registered_;
+    THttpServer* server_;
+    unsigned long nPublished_;
+};
+
+#endif // SnapshotPublisher_h_
@@ -0,0 +1,248 @@
+#ifndef StageTiming_h_
+#define StageTiming_h_
+
+//
+// Low-overhead timing of the event processing stages.
+//
+// StageTiming accumulates, for a number of named stages, the number of
+// calls, the total time spent, and a histogram of the call latencies
+// with logarithmic bins (bin k counts the calls which took from 2^k
+// to 2^(k+1) nanoseconds). It also keeps the wall clock time and the
+// number of bytes read by the event loop, so that the event and data
+// throughputs can be calculated.
+//
+// The stages are timed with ScopedStageTimer objects which read the
+// steady clock in their constructor and destructor. A timer constructed
+// with a NULL StageTiming pointer does nothing, so the instrumented code
+// costs a single branch when the timing is disabled.
+//
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include "TFile.h"
+#include "TH1D.h"
+#include "TNtupleD.h"
+#include "TDirectory.h"
+
+class StageTiming
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    enum {
+        NLatencyBins = 40
+    };
+
+    inline StageTiming() : bytesRead_(0), wallSeconds_(0.0) {}
+
+    // Register a stage and return its number. Registering a stage
+    // with an existing name returns the number of that stage.
+    inline unsigned addStage(const std::string& name)
+    {
+        const unsigned n = stages_.size();
+        for (unsigned i=0; i<n; ++i)
+            if (stages_[i].name == name)
+                return i;
+        stages_.push_back(Stage(name));
+        return n;
+    }
+
+    inline unsigned nStages() const {return stages_.size();}
+    inline const std::string& stageName(const unsigned i) const
+        {return stages_.at(i).name;}
+    inline Long64_t calls(const unsigned i) const
+        {return stages_.at(i).calls;}
+    inline double seconds(const unsigned i) const
+        {return stages_.at(i).nanoseconds*1.0e-9;}
+    inline const std::vector<Long64_t>& latencies(const unsigned i) const
+        {return stages_.at(i).latencies;}
+
+    inline void record(const unsigned stage, const Long64_t nanoseconds)
+    {
+        assert(stage < stages_.size());
+        Stage& s(stages_[stage]);
+        ++s.calls;
+        s.nanoseconds += nanoseconds;
+        unsigned bin = 0;
+        for (Long64_t t = nanoseconds; t > 1 && bin < NLatencyBins-1U; t >>= 1)
+            ++bin;
+        ++s.latencies[bin];
+    }
+
+    inline void addBytesRead(const Long64_t nbytes) {bytesRead_ += nbytes;}
+    inline Long64_t bytesRead() const {return bytesRead_;}
+
+    inline void setWallSeconds(const double s) {wallSeconds_ = s;}
+    inline double wallSeconds() const {return wallSeconds_;}
+
+    // Add the results of another object which timed a different
+    // part of the input in parallel with this one. The stages are
+    // matched by name. The wall clock time is the longer of the two.
+    inline void merge(const StageTiming& other)
+    {
+        const unsigned n = other.stages_.size();
+        for (unsigned i=0; i<n; ++i)
+        {
+            const Stage& o(other.stages_[i]);
+            Stage& s(stages_[addStage(o.name)]);
+            s.calls += o.calls;
+            s.nanoseconds += o.nanoseconds;
+            for (unsigned k=0; k<NLatencyBins; ++k)
+                s.latencies[k] += o.latencies[k];
+        }
+        bytesRead_ += other.bytesRead_;
+        if (other.wallSeconds_ > wallSeconds_)
+            wallSeconds_ = other.wallSeconds_;
+    }
+
+    inline void print(std::ostream& os, const Long64_t eventsRead,
+                      const Long64_t eventsProcessed) const
+    {
+        os << "Stage timing:\n";
+        const unsigned n = stages_.size();
+        for (unsigned i=0; i<n; ++i)
+        {
+            const Stage& s(stages_[i]);
+            if (!s.calls)
+                continue;
+            const double sec = s.nanoseconds*1.0e-9;
+            os << "  " << std::left << std::setw(16) << s.name << std::right
+               << std::setw(12) << s.calls << " calls "
+               << std::setw(12) << sec << " s "
+               << std::setw(12) << s.nanoseconds/static_cast<double>(s.calls)
+               << " ns/call\n";
+        }
+        if (wallSeconds_ > 0.0)
+        {
+            const double mb = bytesRead_/1024.0/1024.0;
+            os << "  Event loop wall time " << wallSeconds_ << " s, "
+               << eventsRead/wallSeconds_ << " events/s read, "
+               << eventsProcessed/wallSeconds_ << " events/s processed, "
+               << mb/wallSeconds_ << " MB/s (" << mb << " MB read)\n";
+        }
+        os.flush();
+    }
+
+    // Write the results into the "Instrumentation" directory of the
+    // given root file (which is updated, not recreated): the latency
+    // histogram of every stage, the histograms of the number of calls
+    // and the total time per stage, and the "Throughput" ntuple with
+    // one entry per job.
+    inline void write(const std::string& filename, const Long64_t eventsRead,
+                      const Long64_t eventsProcessed) const
+    {
+        TFile file(filename.c_str(), "UPDATE");
+        if (!file.IsOpen() || file.IsZombie())
+        {
+            std::ostringstream os;
+            os << "In StageTiming::write: failed to open file \""
+               << filename << '"';
+            throw std::runtime_error(os.str());
+        }
+        TDirectory* dir = file.GetDirectory("Instrumentation");
+        if (!dir)
+            dir = file.mkdir("Instrumentation");
+        if (!dir)
+        {
+            std::ostringstream os;
+            os << "In StageTiming::write: failed to create directory "
+               << "\"Instrumentation\" in file \"" << filename << '"';
+            throw std::runtime_error(os.str());
+        }
+        dir->cd();
+
+        const unsigned n = stages_.size();
+        TH1D calls("StageCalls", "Number of calls per stage", n, 0.0, n);
+        TH1D secs("StageSeconds", "Total time per stage, s", n, 0.0, n);
+        for (unsigned i=0; i<n; ++i)
+        {
+            const Stage& s(stages_[i]);
+            calls.GetXaxis()->SetBinLabel(i + 1, s.name.c_str());
+            calls.SetBinContent(i + 1, s.calls);
+            secs.GetXaxis()->SetBinLabel(i + 1, s.name.c_str());
+            secs.SetBinContent(i + 1, s.nanoseconds*1.0e-9);
+
+            const std::string& hname = "Latency_" + s.name;
+            const std::string& title = "Latency of stage " + s.name;
+            TH1D h(hname.c_str(), title.c_str(),
+                   NLatencyBins, 0.0, NLatencyBins);
+            h.GetXaxis()->SetTitle("log2(latency/ns)");
+            for (unsigned k=0; k<NLatencyBins; ++k)
+                h.SetBinContent(k + 1, s.latencies[k]);
+            h.SetEntries(s.calls);
+            h.Write();
+        }
+        calls.SetEntries(n);
+        secs.SetEntries(n);
+        calls.Write();
+        secs.Write();
+
+        TNtupleD nt("Throughput", "Event loop throughput",
+                    "wallSeconds:eventsRead:eventsProcessed:megabytesRead:"
+                    "eventsPerSecond:megabytesPerSecond");
+        const double mb = bytesRead_/1024.0/1024.0;
+        const double w = wallSeconds_ > 0.0 ? wallSeconds_ : 1.0;
+        const double row[6] = {wallSeconds_, static_cast<double>(eventsRead),
+                               static_cast<double>(eventsProcessed), mb,
+                               eventsRead/w, mb/w};
+        nt.Fill(row);
+        nt.Write();
+        file.Close();
+    }
+
+private:
+    struct Stage
+    {
+        inline explicit Stage(const std::string& n)
+            : name(n), calls(0), nanoseconds(0), latencies(NLatencyBins, 0) {}
+
+        std::string name;
+        Long64_t calls;
+        Long64_t nanoseconds;
+        std::vector<Long64_t> latencies;
+    };
+
+    std::vector<Stage> stages_;
+    Long64_t bytesRead_;
+    double wallSeconds_;
+};
+
+class ScopedStageTimer
+{
+public:
+    inline ScopedStageTimer(StageTiming* timing, const unsigned stage)
+        : timing_(timing), stage_(stage)
+    {
+        if (timing_)
+            start_ = StageTiming::clock_type::now();
+    }
+
+    inline ~ScopedStageTimer()
+    {
+        if (timing_)
+        {
+            const StageTiming::clock_type::duration d =
+                StageTiming::clock_type::now() - start_;
+            timing_->record(stage_, std::chrono::duration_cast<
+                                std::chrono::nanoseconds>(d).count());
+        }
+    }
+
+private:
+    ScopedStageTimer();
+    ScopedStageTimer(const ScopedStageTimer&);
+    ScopedStageTimer& operator=(const ScopedStageTimer&);
+
+    StageTiming* timing_;
+    unsigned stage_;
+    StageTiming::clock_type::time_point start_;
+};
+
+#endif // StageTiming_h_
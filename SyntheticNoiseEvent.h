@@ -0,0 +1,159 @@
+#ifndef SyntheticNoiseEvent_h_
+#define SyntheticNoiseEvent_h_
+
+//
+// Generator of synthetic HBHE events for benchmarking. The class
+// is a NoiseTreeHelper whose tree arrays ("PulseCount", "Depth",
+// "IEta", "IPhi", "Charge", "Pedestal", and "Gain") are filled by
+// the "generate" method instead of being read from a file, so that
+// it can be used with the channel selectors, functors, and managed
+// histograms in place of a real analysis class.
+//
+// Every event contains a number of jets with isotropic directions
+// in the HBHE acceptance. The jet energy is shared among the channels
+// within the cone of a given size around the jet direction (with
+// Gaussian weights). Channels not hit by the jets are read out with
+// the given probability ("occupancy"). All channels get Gaussian
+// electronic noise in every time slice.
+//
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cassert>
+#include <stdexcept>
+
+#include "NoiseTreeHelper.h"
+#include "HBHEChannelMap.h"
+#include "HBHEChannelGeometry.h"
+#include "deltaPhi.h"
+
+class SyntheticNoiseEvent : public NoiseTreeHelper
+{
+public:
+    // The tree is needed only to satisfy the NoiseTreeHelper
+    // interface. An empty TTree is fine.
+    inline SyntheticNoiseEvent(TTree* tree, const HBHEChannelMap& chmap,
+                               const HBHEChannelGeometry& geometry,
+                               const unsigned long seed = 0UL)
+        : NoiseTreeHelper(tree),
+          chmap_(chmap),
+          geometry_(geometry),
+          rng_(seed),
+          channelNumber_(HBHEChannelMap::ChannelCount, 0U),
+          channelEt_(HBHEChannelMap::ChannelCount, 0.0)
+    {
+    }
+
+    inline virtual ~SyntheticNoiseEvent() {}
+
+    // Same interface as in the analysis classes
+    inline unsigned getHBHEChannelNumber(const unsigned pulseNumber) const
+        {return channelNumber_.at(pulseNumber);}
+
+    // Make a new event. "occupancy" is the probability to read out
+    // a channel not hit by a jet, "noiseLevel" is the noise sigma
+    // in fC per time slice.
+    inline void generate(const double occupancy, const unsigned nJets,
+                         const double noiseLevel, const double minJetPt = 20.0,
+                         const double meanJetPt = 30.0,
+                         const double coneSize = 0.4)
+    {
+        if (occupancy < 0.0 || occupancy > 1.0)
+            throw std::invalid_argument("In SyntheticNoiseEvent::generate: "
+                                        "occupancy must be in [0, 1]");
+        if (noiseLevel < 0.0 || coneSize <= 0.0)
+            throw std::invalid_argument("In SyntheticNoiseEvent::generate: "
+                                        "invalid noise level or cone size");
+
+        // Jet Et deposited into the channels
+        const unsigned nChannels = HBHEChannelMap::ChannelCount;
+        const double sigma = coneSize/2.0;
+        std::uniform_real_distribution<double> uni(0.0, 1.0);
+        std::exponential_distribution<double> ptDist(1.0/meanJetPt);
+        channelEt_.assign(nChannels, 0.0);
+        for (unsigned jet=0; jet<nJets; ++jet)
+        {
+            const double pt = minJetPt + ptDist(rng_);
+            const double eta = -MaxJetEta + 2.0*MaxJetEta*uni(rng_);
+            const double phi = 2.0*M_PI*uni(rng_);
+            weights_.assign(nChannels, 0.0);
+            double wsum = 0.0;
+            for (unsigned ch=0; ch<nChannels; ++ch)
+            {
+                const double deta = geometry_.getEta(ch) - eta;
+                const double dphi = nta::deltaPhi(geometry_.getPhi(ch), phi);
+                const double dr2 = deta*deta + dphi*dphi;
+                if (dr2 < coneSize*coneSize)
+                {
+                    weights_[ch] = std::exp(-dr2/2.0/sigma/sigma);
+                    wsum += weights_[ch];
+                }
+            }
+            if (wsum > 0.0)
+                for (unsigned ch=0; ch<nChannels; ++ch)
+                    channelEt_[ch] += pt*weights_[ch]/wsum;
+        }
+
+        // Fill the tree arrays
+        std::normal_distribution<double> noise(0.0, noiseLevel);
+        std::normal_distribution<double> pedSpread(0.0, 0.1);
+        unsigned n = 0;
+        for (unsigned ch=0; ch<nChannels; ++ch)
+        {
+            const bool hit = channelEt_[ch] > 0.0;
+            if (!hit && uni(rng_) >= occupancy)
+                continue;
+
+            unsigned depth, iphi;
+            int ieta;
+            chmap_.getChannelTriple(ch, &depth, &ieta, &iphi);
+            Depth[n] = depth;
+            IEta[n] = ieta;
+            IPhi[n] = iphi;
+            channelNumber_[n] = ch;
+
+            const double gain = NominalGain*(1.0 + 0.05*(2.0*uni(rng_) - 1.0));
+            const double ped = NominalPedestal + pedSpread(rng_);
+            const double e = channelEt_[ch]*std::cosh(geometry_.getEta(ch));
+            const double q = e/gain;
+            for (unsigned ts=0; ts<N_TIME_SLICES; ++ts)
+            {
+                Pedestal[n][ts] = ped;
+                Gain[n][ts] = gain;
+                Charge[n][ts] = ped + q*pulseFraction(ts) + noise(rng_);
+            }
+            ++n;
+        }
+        PulseCount = n;
+        invalidateEnergies();
+    }
+
+private:
+    SyntheticNoiseEvent();
+    SyntheticNoiseEvent(const SyntheticNoiseEvent&);
+    SyntheticNoiseEvent& operator=(const SyntheticNoiseEvent&);
+
+    // Nominal electronics parameters: gain in GeV/fC,
+    // pedestal in fC per time slice
+    static constexpr double NominalGain = 0.2;
+    static constexpr double NominalPedestal = 3.0;
+    static constexpr double MaxJetEta = 2.5;
+
+    // Fraction of the pulse charge in the given time slice
+    static inline double pulseFraction(const unsigned ts)
+    {
+        static const double fractions[N_TIME_SLICES] = {
+            0.0, 0.0, 0.0, 0.02, 0.70, 0.20, 0.06, 0.02, 0.0, 0.0};
+        return fractions[ts];
+    }
+
+    const HBHEChannelMap& chmap_;
+    const HBHEChannelGeometry& geometry_;
+    std::mt19937_64 rng_;
+    std::vector<unsigned> channelNumber_;
+    std::vector<double> channelEt_;
+    std::vector<double> weights_;
+};
+
+#endif // SyntheticNoiseEvent_h_
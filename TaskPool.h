@@ -0,0 +1,188 @@
+#ifndef TaskPool_h_
+#define TaskPool_h_
+
+//
+// A fixed pool of helper threads for the parallel loops inside one
+// event (see FFTJetChannelSelector::setTaskPool). A single pool is made
+// by the executable and shared by all analysis instances, so the total
+// number of threads is limited by the "-j" option plus the pool size,
+// no matter how many workers process large events at the same time.
+// The executable also keeps this total within the number of hardware
+// threads (see "maxHelpers"), since the workers which start parallel
+// loops take part in them and extra helpers would only compete with
+// the workers for the cores.
+//
+// The thread calling "parallelFor" takes part in the work, so the loop
+// makes progress even if all helpers are busy with loops started by
+// other threads. Loops started by different threads are served in the
+// order of their submission.
+//
+
+#include <deque>
+#include <climits>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <cassert>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+class TaskPool
+{
+public:
+    // "nHelpers" can be 0, then "parallelFor" runs the loop serially
+    inline explicit TaskPool(const unsigned nHelpers)
+        : stop_(false)
+    {
+        helpers_.reserve(nHelpers);
+        for (unsigned i=0; i<nHelpers; ++i)
+            helpers_.push_back(std::thread(&TaskPool::helperLoop, this));
+    }
+
+    inline ~TaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wakeHelpers_.notify_all();
+        const unsigned n = helpers_.size();
+        for (unsigned i=0; i<n; ++i)
+            helpers_[i].join();
+    }
+
+    // Number of threads which can work on one loop
+    inline unsigned concurrency() const {return helpers_.size() + 1U;}
+
+    // The largest number of helpers which, together with "nWorkers"
+    // threads of the event loop, does not exceed the number of hardware
+    // threads. Returns UINT_MAX if the number of hardware threads is
+    // not known.
+    static inline unsigned maxHelpers(const unsigned nWorkers)
+    {
+        const unsigned nCores = std::thread::hardware_concurrency();
+        if (!nCores)
+            return UINT_MAX;
+        return nCores > nWorkers ? nCores - nWorkers : 0U;
+    }
+
+    // Call "task(i)" for every i from 0 to nTasks - 1 and wait until
+    // all calls return. The calls may happen in any order and in
+    // different threads. If a task throws, the remaining tasks are
+    // still run and the first exception is rethrown here.
+    inline void parallelFor(const unsigned nTasks,
+                            const std::function<void(unsigned)>& task)
+    {
+        if (nTasks == 0U)
+            return;
+        if (nTasks == 1U || helpers_.empty())
+        {
+            for (unsigned i=0; i<nTasks; ++i)
+                task(i);
+            return;
+        }
+
+        Loop loop(nTasks, task);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(&loop);
+        }
+        wakeHelpers_.notify_all();
+
+        runTasks(&loop);
+
+        // Wait for the tasks taken by the helpers. The loop object
+        // must not be destroyed while some helper still refers to it.
+        std::unique_lock<std::mutex> lock(mutex_);
+        loopDone_.wait(lock, [&loop]{
+                return loop.nDone == loop.nTasks && !loop.nHelpers;});
+        const std::deque<Loop*>::iterator it =
+            std::find(queue_.begin(), queue_.end(), &loop);
+        if (it != queue_.end())
+            queue_.erase(it);
+        if (loop.error)
+            std::rethrow_exception(loop.error);
+    }
+
+private:
+    TaskPool(const TaskPool&);
+    TaskPool& operator=(const TaskPool&);
+
+    struct Loop
+    {
+        inline Loop(const unsigned n, const std::function<void(unsigned)>& f)
+            : task(f), nTasks(n), next(0), nDone(0), nHelpers(0) {}
+
+        const std::function<void(unsigned)>& task;
+        const unsigned nTasks;
+        std::atomic<unsigned> next;
+
+        // Protected by the pool mutex
+        unsigned nDone;
+        unsigned nHelpers;
+        std::exception_ptr error;
+    };
+
+    // Run the tasks of the loop until none are left to take
+    inline void runTasks(Loop* loop)
+    {
+        unsigned nRun = 0;
+        std::exception_ptr error;
+        for (unsigned i = loop->next++; i < loop->nTasks; i = loop->next++)
+        {
+            try {
+                loop->task(i);
+            }
+            catch (...) {
+                if (!error)
+                    error = std::current_exception();
+            }
+            ++nRun;
+        }
+        if (nRun)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            loop->nDone += nRun;
+            if (error && !loop->error)
+                loop->error = error;
+        }
+    }
+
+    inline void helperLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            // Drop the loops which have no tasks left to take
+            while (!queue_.empty() &&
+                   queue_.front()->next.load() >= queue_.front()->nTasks)
+                queue_.pop_front();
+            if (!queue_.empty())
+            {
+                Loop* loop = queue_.front();
+                ++loop->nHelpers;
+                lock.unlock();
+                runTasks(loop);
+                lock.lock();
+                --loop->nHelpers;
+                loopDone_.notify_all();
+            }
+            else if (stop_)
+                return;
+            else
+                wakeHelpers_.wait(lock);
+        }
+    }
+
+    std::vector<std::thread> helpers_;
+    std::deque<Loop*> queue_;
+    std::mutex mutex_;
+    std::condition_variable wakeHelpers_;
+    std::condition_variable loopDone_;
+    bool stop_;
+};
+
+#endif // TaskPool_h_
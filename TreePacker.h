@@ -0,0 +1,187 @@
+#ifndef TreePacker_h_
+#define TreePacker_h_
+
+//
+// Helper classes and functions for generating typed TTree branches
+// from an initial specification defined by std::tuple of columns
+// (see Column.h). This is the analog of NtuplePacker.h for AutoTree,
+// CycledTree, and CycledArrayTree. The branch type of every column
+// is inferred at compile time from the type returned by its functor.
+// Supported types are bool, the signed and unsigned integer types
+// of 8, 16, 32, and 64 bits, float, and double.
+//
+
+#include <tuple>
+#include <vector>
+#include <string>
+#include <cassert>
+#include <utility>
+#include <type_traits>
+
+#include "TTree.h"
+#include "TBranch.h"
+
+#include "Column.h"
+
+namespace tupleutils
+{
+    // Branch storage type and root leaf type code for the values of type T.
+    // Bools are stored as unsigned char in order to avoid std::vector<bool>.
+    template<typename T, unsigned Size = sizeof(T),
+             bool Signed = std::is_signed<T>::value,
+             bool Integral = std::is_integral<T>::value>
+    struct TreeLeafType;
+
+    template<>
+    struct TreeLeafType<bool, sizeof(bool), false, true>
+        {typedef unsigned char storage_type; static char code() {return 'O';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 1U, true, true>
+        {typedef Char_t storage_type; static char code() {return 'B';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 1U, false, true>
+        {typedef UChar_t storage_type; static char code() {return 'b';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 2U, true, true>
+        {typedef Short_t storage_type; static char code() {return 'S';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 2U, false, true>
+        {typedef UShort_t storage_type; static char code() {return 's';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 4U, true, true>
+        {typedef Int_t storage_type; static char code() {return 'I';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 4U, false, true>
+        {typedef UInt_t storage_type; static char code() {return 'i';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 8U, true, true>
+        {typedef Long64_t storage_type; static char code() {return 'L';}};
+
+    template<typename T>
+    struct TreeLeafType<T, 8U, false, true>
+        {typedef ULong64_t storage_type; static char code() {return 'l';}};
+
+    template<>
+    struct TreeLeafType<float, sizeof(float), true, false>
+        {typedef Float_t storage_type; static char code() {return 'F';}};
+
+    template<>
+    struct TreeLeafType<double, sizeof(double), true, false>
+        {typedef Double_t storage_type; static char code() {return 'D';}};
+
+    // Type of the value returned by the column functor. "Cycled"
+    // functors are called with an unsigned argument.
+    template<class Functor, bool Cycled>
+    struct ColumnValueType
+    {
+        typedef typename std::decay<
+            decltype(std::declval<const Functor&>()())>::type type;
+    };
+
+    template<class Functor>
+    struct ColumnValueType<Functor, true>
+    {
+        typedef typename std::decay<
+            decltype(std::declval<const Functor&>()(0U))>::type type;
+    };
+
+    // Storage for one branch: a single value or a variable-length array
+    template<typename T>
+    struct TreeColumnBuffer
+    {
+        typedef TreeLeafType<T> leaf_type;
+        typedef typename leaf_type::storage_type storage_type;
+
+        inline TreeColumnBuffer() : value(), branch(0) {values.reserve(1);}
+
+        storage_type value;
+        std::vector<storage_type> values;
+        TBranch* branch;
+    };
+
+    template<class Pack, bool Cycled>
+    struct TreeBufferTuple;
+
+    template<class... Functors, bool Cycled>
+    struct TreeBufferTuple<std::tuple<ColumnHelper<Functors>...>, Cycled>
+    {
+        typedef std::tuple<TreeColumnBuffer<
+            typename ColumnValueType<Functors, Cycled>::type>...> type;
+    };
+
+    template<typename Pack, typename Buffers, int N>
+    struct TreeBranchCycler
+    {
+        // Create scalar branches. If "counter" is not null, create
+        // variable-length array branches with the given counter leaf.
+        inline static void book(TTree* tree, const Pack& p, Buffers& b,
+                                const char* counter)
+        {
+            TreeBranchCycler<Pack, Buffers, N-1>::book(tree, p, b, counter);
+            typedef typename std::tuple_element<N-1, Buffers>::type Buf;
+            const std::string& name = (std::get<N-1>(p)).name;
+            std::string leaves(name);
+            if (counter)
+                leaves += std::string("[") + counter + ']';
+            leaves += '/';
+            leaves += Buf::leaf_type::code();
+            Buf& buf(std::get<N-1>(b));
+            void* address = counter ? static_cast<void*>(buf.values.data())
+                                    : static_cast<void*>(&buf.value);
+            buf.branch = tree->Branch(name.c_str(), address, leaves.c_str());
+            assert(buf.branch);
+        }
+
+        inline static void fill(const Pack& p, Buffers& b)
+        {
+            TreeBranchCycler<Pack, Buffers, N-1>::fill(p, b);
+            std::get<N-1>(b).value = (std::get<N-1>(p)).fcn();
+        }
+
+        inline static void fill(const Pack& p, Buffers& b, const unsigned i)
+        {
+            TreeBranchCycler<Pack, Buffers, N-1>::fill(p, b, i);
+            std::get<N-1>(b).value = (std::get<N-1>(p)).fcn(i);
+        }
+
+        inline static void clearArrays(Buffers& b)
+        {
+            TreeBranchCycler<Pack, Buffers, N-1>::clearArrays(b);
+            std::get<N-1>(b).values.clear();
+        }
+
+        inline static void append(const Pack& p, Buffers& b, const unsigned i)
+        {
+            TreeBranchCycler<Pack, Buffers, N-1>::append(p, b, i);
+            std::get<N-1>(b).values.push_back((std::get<N-1>(p)).fcn(i));
+        }
+
+        // Vectors may have been reallocated by "append"
+        inline static void updateArrayAddresses(Buffers& b)
+        {
+            TreeBranchCycler<Pack, Buffers, N-1>::updateArrayAddresses(b);
+            std::get<N-1>(b).branch->SetAddress(std::get<N-1>(b).values.data());
+        }
+    };
+
+    template<typename Pack, typename Buffers>
+    struct TreeBranchCycler<Pack, Buffers, 0>
+    {
+        inline static void book(TTree* tree, const Pack&, Buffers&, const char*)
+            {assert(tree);}
+        inline static void fill(const Pack&, Buffers&) {}
+        inline static void fill(const Pack&, Buffers&, unsigned) {}
+        inline static void clearArrays(Buffers&) {}
+        inline static void append(const Pack&, Buffers&, unsigned) {}
+        inline static void updateArrayAddresses(Buffers&) {}
+    };
+}
+
+#endif // TreePacker_h_
@@ -0,0 +1,101 @@
+#ifndef chainSharding_h_
+#define chainSharding_h_
+
+//
+// Utilities for splitting the entries of a TChain into contiguous
+// "shards" which can be processed by independent batch jobs.
+//
+// The shard boundaries are balanced by the number of entries. They
+// are moved to the nearest preceding basket cluster boundary (so that
+// no cluster is read and decompressed by two jobs) or, if the split
+// is performed by file, to the nearest file boundary. Shard k of N
+// covers the entries [boundary(k), boundary(k+1)) of the chain (or of
+// its part starting from "firstEntry"), so that the shards k = 0, ...,
+// N-1 together cover the chain exactly once.
+//
+
+#include <string>
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include "TChain.h"
+
+// Parse the shard specification in the form "k/N"
+inline void parseShardSpec(const std::string& spec,
+                           unsigned* shard, unsigned* nShards)
+{
+    const std::size_t slash = spec.find('/');
+    bool ok = slash != std::string::npos && slash > 0U &&
+              slash + 1U < spec.size() &&
+              spec.find_first_not_of("0123456789/") == std::string::npos &&
+              spec.find('/', slash + 1U) == std::string::npos;
+    if (ok)
+    {
+        *shard = std::strtoul(spec.substr(0, slash).c_str(), 0, 10);
+        *nShards = std::strtoul(spec.substr(slash + 1U).c_str(), 0, 10);
+        ok = *nShards > 0U && *shard < *nShards;
+    }
+    if (!ok)
+    {
+        std::ostringstream os;
+        os << "In parseShardSpec: invalid shard specification \""
+           << spec << "\", expected k/N with 0 <= k < N";
+        throw std::invalid_argument(os.str());
+    }
+}
+
+// Start of the basket cluster (or of the file, if "byFile" is true)
+// which contains the given chain entry
+inline Long64_t chainShardBoundary(TChain* chain, const Long64_t entry,
+                                   const bool byFile)
+{
+    assert(chain);
+    const Long64_t local = chain->LoadTree(entry);
+    if (local < 0)
+        return entry;
+    const Long64_t treeStart = entry - local;
+    if (byFile)
+        return treeStart;
+    TTree* tree = chain->GetTree();
+    assert(tree);
+    TTree::TClusterIterator clusters = tree->GetClusterIterator(local);
+    return treeStart + clusters.Next();
+}
+
+// Determine the entry range [*first, *last) of the given shard.
+// The chain part being split starts at "firstEntry".
+inline void chainShardRange(TChain* chain, const Long64_t firstEntry,
+                            const unsigned shard, const unsigned nShards,
+                            const bool byFile,
+                            Long64_t* first, Long64_t* last)
+{
+    assert(chain);
+    assert(shard < nShards);
+    assert(firstEntry >= 0);
+
+    const Long64_t nentries = chain->GetEntries();
+    const Long64_t start = firstEntry < nentries ? firstEntry : nentries;
+    const Long64_t len = nentries - start;
+
+    Long64_t bounds[2];
+    for (unsigned i=0; i<2; ++i)
+    {
+        const unsigned k = shard + i;
+        if (k == 0U)
+            bounds[i] = start;
+        else if (k == nShards)
+            bounds[i] = nentries;
+        else
+        {
+            const Long64_t target = start + (len*k)/nShards;
+            const Long64_t b = chainShardBoundary(chain, target, byFile);
+            bounds[i] = b > start ? b : start;
+        }
+    }
+    *first = bounds[0];
+    *last = bounds[1];
+}
+
+#endif // chainSharding_h_
@@ -0,0 +1,46 @@
+#ifndef convertCSVIntoVector_h_
+#define convertCSVIntoVector_h_
+
+//
+// Convert a string of comma-separated values into a vector of numbers
+// (or other objects which can be read from an istream). The order of
+// values is preserved. std::invalid_argument is thrown if some value
+// can not be converted or if the input is empty.
+//
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+template <typename T>
+std::vector<T> convertCSVIntoVector(const std::string& input,
+                                    const char* name)
+{
+    std::vector<T> result;
+    std::istringstream is(input);
+    std::string token;
+    while (std::getline(is, token, ','))
+    {
+        std::istringstream ts(token);
+        T value;
+        ts >> value >> std::ws;
+        if (ts.fail() || !ts.eof())
+        {
+            std::ostringstream os;
+            os << "In convertCSVIntoVector: invalid \"" << name
+               << "\" value \"" << token << '"';
+            throw std::invalid_argument(os.str());
+        }
+        result.push_back(value);
+    }
+    if (result.empty())
+    {
+        std::ostringstream os;
+        os << "In convertCSVIntoVector: no \"" << name << "\" values";
+        throw std::invalid_argument(os.str());
+    }
+    return result;
+}
+
+#endif // convertCSVIntoVector_h_
@@ -7,8 +7,9 @@
 // Classes which build 4-momenta out of energy and direction
 #include "VBuilders.h"
 
-// Header file for the concrete FFT engine used
+// Header files for the concrete FFT engines used
 #include "fftjet/FFTWDoubleEngine.hh"
+#include "fftjet/FFTWFloatEngine.hh"
 
 // Header file for the functor interface
 #include "fftjet/SimpleFunctors.hh"
@@ -19,6 +20,26 @@ typedef double Real;
 typedef fftw_complex Complex;
 typedef fftjet::FFTWDoubleEngine MyFFTEngine;
 
+// Complex type and FFT engine for pattern recognition performed
+// with the given real type (double or float). The default precision
+// is the one defined by the "Real" typedef above.
+template <typename RealType>
+struct FFTJetPrecision;
+
+template <>
+struct FFTJetPrecision<double>
+{
+    typedef fftw_complex Complex;
+    typedef fftjet::FFTWDoubleEngine Engine;
+};
+
+template <>
+struct FFTJetPrecision<float>
+{
+    typedef fftwf_complex Complex;
+    typedef fftjet::FFTWFloatEngine Engine;
+};
+
 // The next typedef reflects the choice of the 4-vector class
 typedef TLorentzVector VectorLike;
 
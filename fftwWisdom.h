@@ -0,0 +1,159 @@
+#ifndef fftwWisdom_h_
+#define fftwWisdom_h_
+
+//
+// Utilities for keeping FFTW "wisdom" (accumulated knowledge about
+// the best DFFT plans) in a file, and for choosing the FFTW planner
+// rigor by name.
+//
+// With the "measure" or more rigorous planner settings, building DFFT
+// plans can take much longer than processing a short job. The plans
+// for a given grid geometry can be calculated once and then reused by
+// all jobs if the wisdom is loaded before the plans are created and
+// saved after that. A single file can hold the wisdom for several
+// grid geometries.
+//
+// Double and single precision versions of FFTW keep their wisdom
+// separately. The "importFFTWWisdom" and "exportFFTWWisdom" functions
+// are templated on the real type. For single precision, the wisdom is
+// kept in the file whose name is made by appending ".float" to the
+// name given.
+//
+// Note that the FFTW planner is not thread-safe, so these functions
+// should be called from one thread only. The wisdom file is replaced
+// atomically (by renaming a temporary file), so it is safe to use one
+// file in many simultaneously running programs.
+//
+
+#include <cstdio>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "fftw3.h"
+
+namespace Private {
+    template <typename Real>
+    struct FFTWWisdomAPI;
+
+    template <>
+    struct FFTWWisdomAPI<double>
+    {
+        static std::string fileName(const std::string& name) {return name;}
+        static int importString(const char* w)
+            {return fftw_import_wisdom_from_string(w);}
+        static char* exportString() {return fftw_export_wisdom_to_string();}
+        static void release(char* w) {fftw_free(w);}
+    };
+
+    template <>
+    struct FFTWWisdomAPI<float>
+    {
+        static std::string fileName(const std::string& name)
+            {return name + ".float";}
+        static int importString(const char* w)
+            {return fftwf_import_wisdom_from_string(w);}
+        static char* exportString() {return fftwf_export_wisdom_to_string();}
+        static void release(char* w) {fftwf_free(w);}
+    };
+}
+
+// Convert planner rigor name ("estimate", "measure", "patient",
+// or "exhaustive") into the corresponding FFTW planner flag
+inline unsigned fftwPlannerFlag(const std::string& rigor)
+{
+    if (rigor == "estimate")
+        return FFTW_ESTIMATE;
+    else if (rigor == "measure")
+        return FFTW_MEASURE;
+    else if (rigor == "patient")
+        return FFTW_PATIENT;
+    else if (rigor == "exhaustive")
+        return FFTW_EXHAUSTIVE;
+    else
+    {
+        std::ostringstream os;
+        os << "In fftwPlannerFlag: unsupported FFTW planner rigor \""
+           << rigor << "\". Valid values are \"estimate\", \"measure\", "
+           << "\"patient\", and \"exhaustive\".";
+        throw std::invalid_argument(os.str());
+    }
+}
+
+// Import FFTW wisdom from the given file. Returns the wisdom string
+// read from the file. A missing file is not an error (the function
+// returns an empty string in that case). A file which exists but
+// can not be imported is an error.
+template <typename Real = double>
+inline std::string importFFTWWisdom(const std::string& name)
+{
+    typedef Private::FFTWWisdomAPI<Real> API;
+
+    const std::string& filename = API::fileName(name);
+    std::string wisdom;
+    std::ifstream is(filename.c_str());
+    if (is.is_open())
+    {
+        wisdom.assign(std::istreambuf_iterator<char>(is),
+                      std::istreambuf_iterator<char>());
+        if (!API::importString(wisdom.c_str()))
+        {
+            std::ostringstream os;
+            os << "In importFFTWWisdom: failed to import FFTW wisdom "
+               << "from file \"" << filename << '"';
+            throw std::runtime_error(os.str());
+        }
+    }
+    return wisdom;
+}
+
+// Export the current FFTW wisdom into the given file if it differs
+// from the "previous" wisdom (normally, the value returned by
+// "importFFTWWisdom"). Returns "true" if the file was written.
+template <typename Real = double>
+inline bool exportFFTWWisdom(const std::string& name,
+                             const std::string& previous)
+{
+    typedef Private::FFTWWisdomAPI<Real> API;
+
+    char* w = API::exportString();
+    if (!w)
+        throw std::runtime_error("In exportFFTWWisdom: failed to export "
+                                 "FFTW wisdom");
+    const std::string wisdom(w);
+    API::release(w);
+    const std::string& filename = API::fileName(name);
+    if (wisdom == previous)
+        return false;
+
+    std::ostringstream tmpname;
+    tmpname << filename << ".tmp" << getpid();
+    const std::string& tmp = tmpname.str();
+    {
+        std::ofstream of(tmp.c_str());
+        of << wisdom;
+        of.close();
+        if (of.fail())
+        {
+            std::remove(tmp.c_str());
+            std::ostringstream os;
+            os << "In exportFFTWWisdom: failed to write file \""
+               << tmp << '"';
+            throw std::runtime_error(os.str());
+        }
+    }
+    if (std::rename(tmp.c_str(), filename.c_str()))
+    {
+        std::remove(tmp.c_str());
+        std::ostringstream os;
+        os << "In exportFFTWWisdom: failed to rename file \""
+           << tmp << "\" into \"" << filename << '"';
+        throw std::runtime_error(os.str());
+    }
+    return true;
+}
+
+#endif // fftwWisdom_h_
@@ -2,16 +2,22 @@
 #define FILLTUPLESFROMTEXT_H_
 
 // Externally useable functions defined in this file are
-// "fillTuplesFromText" and "tupleString".
+// "fillTuplesFromText", "fillTuplesFromBuffer", "fillTuplesFromFile",
+// and "tupleString".
 
 #include <vector>
 #include <tuple>
 #include <string>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <climits>
 #include <cstddef>
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <type_traits>
 
 namespace Private {
     template <typename Tuple, std::size_t N>
@@ -56,6 +62,136 @@ namespace Private {
     {
         inline static void print(std::ostream&, const Tuple&, const char*) {}
     };  
+
+    // Field parsers for "fillTuplesFromBuffer". Each parser starts
+    // at a non-blank character, advances "p" past the field, and
+    // returns "false" if the field can not be converted. Integers
+    // and floating point numbers are converted with the C library
+    // functions, everything else with an istringstream.
+    inline bool isFieldBlank(const char c, const bool commas)
+        {return c == ' ' || c == '\t' || c == '\r' || c == '\v' ||
+                c == '\f' || (commas && c == ',');}
+
+    inline const char* fieldEnd(const char* p, const bool commas)
+    {
+        while (*p && *p != '\n' && !isFieldBlank(*p, commas))
+            ++p;
+        return p;
+    }
+
+    template <typename T, bool Integral = std::is_integral<T>::value &&
+              !std::is_same<T,char>::value &&
+              !std::is_same<T,signed char>::value &&
+              !std::is_same<T,unsigned char>::value,
+              bool Floating = std::is_floating_point<T>::value>
+    struct FieldParser
+    {
+        inline static bool parse(const char*& p, const bool commas, T* value)
+        {
+            const char* end = fieldEnd(p, commas);
+            std::istringstream is(std::string(p, end));
+            is >> *value;
+            if (is.fail())
+                return false;
+            if (is.eof())
+                p = end;
+            else
+                p += static_cast<std::streamoff>(is.tellg());
+            return true;
+        }
+    };
+
+    template <typename T>
+    struct FieldParser<T, true, false>
+    {
+        inline static bool parse(const char*& p, const bool, T* value)
+        {
+            char* end = 0;
+            errno = 0;
+            if (std::numeric_limits<T>::is_signed)
+            {
+                const long long v = std::strtoll(p, &end, 10);
+                if (end == p || errno == ERANGE ||
+                    v < static_cast<long long>(std::numeric_limits<T>::min()) ||
+                    v > static_cast<long long>(std::numeric_limits<T>::max()))
+                    return false;
+                *value = static_cast<T>(v);
+            }
+            else
+            {
+                const unsigned long long v = std::strtoull(p, &end, 10);
+                if (end == p || errno == ERANGE ||
+                    v > static_cast<unsigned long long>(
+                        std::numeric_limits<T>::max()))
+                    return false;
+                *value = static_cast<T>(v);
+            }
+            p = end;
+            return true;
+        }
+    };
+
+    inline void convertFloat(const char* p, char** end, float* v)
+        {*v = std::strtof(p, end);}
+    inline void convertFloat(const char* p, char** end, double* v)
+        {*v = std::strtod(p, end);}
+    inline void convertFloat(const char* p, char** end, long double* v)
+        {*v = std::strtold(p, end);}
+
+    template <typename T>
+    struct FieldParser<T, false, true>
+    {
+        inline static bool parse(const char*& p, const bool, T* value)
+        {
+            char* end = 0;
+            errno = 0;
+            convertFloat(p, &end, value);
+            if (end == p || (errno == ERANGE &&
+                             (*value > 1 || *value < -1)))
+                return false;
+            p = end;
+            return true;
+        }
+    };
+
+    template <>
+    struct FieldParser<std::string, false, false>
+    {
+        inline static bool parse(const char*& p, const bool commas,
+                                 std::string* value)
+        {
+            const char* end = fieldEnd(p, commas);
+            value->assign(p, end);
+            p = end;
+            return true;
+        }
+    };
+
+    template <typename Tuple, std::size_t N>
+    struct TupleBufferCycler
+    {
+        inline static bool read(const char*& p, const bool commas, Tuple* t)
+        {
+            if (!TupleBufferCycler<Tuple, N-1>::read(p, commas, t))
+                return false;
+            while (isFieldBlank(*p, commas))
+                ++p;
+            if (!*p || *p == '\n')
+                return false;
+            typedef typename std::tuple_element<N-1, Tuple>::type Field;
+            return FieldParser<Field>::parse(p, commas, &std::get<N-1>(*t));
+        }
+    };
+
+    template <typename Tuple>
+    struct TupleBufferCycler<Tuple, 0>
+    {
+        inline static bool read(const char*&, bool, Tuple* t)
+        {
+            assert(t);
+            return true;
+        }
+    };
 }
 
 
@@ -128,6 +264,104 @@ bool fillTuplesFromText(std::istream& asciiStream,
 }
 
 
+// Faster version of "fillTuplesFromText" which parses a text buffer
+// in memory. The buffer must be terminated by a null character. Lines
+// are treated exactly as in "fillTuplesFromText": empty lines and
+// comment lines are skipped, and anything which follows the last tuple
+// element in a line is ignored. The vector is reserved in advance for
+// the number of lines in the buffer. On failure, the number of the
+// first line which could not be parsed (counting from 1) is stored
+// in "*errorLine", if provided. The function returns "true" on success,
+// "false" on failure.
+template <typename Tuple>
+bool fillTuplesFromBuffer(const char* buffer,
+                          std::vector<Tuple>* tofill,
+                          const bool hasCommasBetweenValues = false,
+                          const unsigned long maxElementsToFill = ULONG_MAX,
+                          unsigned long* errorLine = 0)
+{
+    assert(buffer);
+    assert(tofill);
+    if (errorLine)
+        *errorLine = 0;
+    if (!maxElementsToFill)
+        return true;
+
+    unsigned long nLines = 1;
+    for (const char* c = buffer; *c; ++c)
+        if (*c == '\n')
+            ++nLines;
+    tofill->reserve(tofill->size() +
+                    (nLines < maxElementsToFill ? nLines : maxElementsToFill));
+
+    const bool commas = hasCommasBetweenValues;
+    unsigned long nfilled = 0, lineNumber = 0;
+    Tuple buf;
+    const char* p = buffer;
+    while (*p && nfilled<maxElementsToFill)
+    {
+        ++lineNumber;
+        const char* line = p;
+        while (Private::isFieldBlank(*line, commas))
+            ++line;
+        const bool skip = !*line || *line == '\n' || *line == '#';
+        if (!skip)
+        {
+            const char* q = line;
+            if (!Private::TupleBufferCycler<
+                    Tuple,std::tuple_size<Tuple>::value>::read(q, commas, &buf))
+            {
+                if (errorLine)
+                    *errorLine = lineNumber;
+                return false;
+            }
+            tofill->push_back(buf);
+            ++nfilled;
+        }
+
+        // Go to the next line
+        while (*p && *p != '\n')
+            ++p;
+        if (*p)
+            ++p;
+    }
+    return true;
+}
+
+
+// Read the whole file into memory and parse it with "fillTuplesFromBuffer".
+// If the file can not be opened, "*errorLine" is set to 0 and "false"
+// is returned.
+template <typename Tuple>
+bool fillTuplesFromFile(const char* filename,
+                        std::vector<Tuple>* tofill,
+                        const bool hasCommasBetweenValues = false,
+                        const unsigned long maxElementsToFill = ULONG_MAX,
+                        unsigned long* errorLine = 0)
+{
+    assert(filename);
+    if (errorLine)
+        *errorLine = 0;
+    std::ifstream is(filename, std::ios_base::binary);
+    if (!is.is_open())
+        return false;
+    std::string contents;
+    is.seekg(0, std::ios_base::end);
+    const std::streamoff len = is.tellg();
+    if (len > 0)
+    {
+        contents.resize(static_cast<std::size_t>(len));
+        is.seekg(0, std::ios_base::beg);
+        is.read(&contents[0], len);
+        if (is.gcount() != len)
+            return false;
+    }
+    return fillTuplesFromBuffer(contents.c_str(), tofill,
+                                hasCommasBetweenValues,
+                                maxElementsToFill, errorLine);
+}
+
+
 // The following function returns a human-readable string representing a tuple.
 // If the separator for tuple elements is not provided, single space will be used.
 template <typename Tuple>
@@ -0,0 +1,230 @@
+#ifndef processChainInParallel_h_
+#define processChainInParallel_h_
+
+//
+// Multithreaded driver for analysis classes derived from RootChainProcessor.
+//
+// The entry range [firstEntry, lastEntry) of the input chain (negative
+// "lastEntry" means the end of the chain) is split into "nThreads" contiguous
+// parts of (approximately) equal size. Each part is processed by its own
+// instance of the analysis class, with its own TChain, tree branch buffers,
+// channel selectors, and HistogramManager. The first instance writes its
+// results into the real output file while the other instances write into
+// temporary files. When all event loops are finished, the results of the
+// other instances are merged into the first one in the order of their
+// entry ranges (so that the output is reproducible), the "endJob" method
+// of the first instance is called, and the temporary files are removed.
+//
+// Note that, when the maximum number of events to process is limited,
+// the workers share a single event counter. In this case the total
+// number of processed events is still correct but the choice of events
+// depends on the relative speed of the threads.
+//
+// If the "configure" functor is provided, it is called on every analysis
+// instance after its construction (this is the place to apply the
+// command line settings which are not a part of the analysis options).
+//
+// If "timing" is not NULL, it is filled with the stage timing results
+// of all workers (these are meaningful only if the timing was enabled
+// by the "configure" functor, see RootChainProcessor::enableTiming).
+// Similarly, "memory" is filled with the memory samples of all workers
+// (see RootChainProcessor::enableMemoryProfile).
+//
+// Only the first analysis instance is constructed with the "verbose"
+// flag set, so that the diagnostic printouts of different threads
+// are not interleaved.
+//
+// If "shareHistograms" is true, the histograms of all workers share
+// their bins (see "SharedHisto.h"). The shared contents are written
+// into the histograms of the first instance before the results of the
+// other instances are merged (the items which can not be shared, like
+// ntuples, are merged as usual). The analysis class must pass the store
+// to its HistogramManager, see RootChainProcessor::getSharedHistoStore.
+//
+// The function returns the status appropriate for returning from "main".
+//
+
+#include <set>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <cstdio>
+#include <sstream>
+#include <iostream>
+#include <exception>
+
+#include "TROOT.h"
+#include "TChain.h"
+
+#include "StageTiming.h"
+#include "MemoryProfile.h"
+#include "SharedHisto.h"
+
+namespace Private {
+    inline std::string workerOutputFile(const std::string& outfile,
+                                        const unsigned iworker)
+    {
+        std::ostringstream os;
+        const std::size_t len = outfile.size();
+        if (len > 5U && outfile.compare(len - 5U, 5U, ".root") == 0)
+            os << outfile.substr(0, len - 5U) << "_worker"
+               << iworker << ".root";
+        else
+            os << outfile << "_worker" << iworker;
+        return os.str();
+    }
+
+    template <class AnalysisClass>
+    void runWorkerEventLoop(AnalysisClass* analysis, const bool callEndJob,
+                            int* status)
+    {
+        try {
+            *status = analysis->runEventLoop();
+            if (callEndJob)
+            {
+                const int endStatus = analysis->finish();
+                if (!*status)
+                    *status = endStatus;
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error in processChainInParallel: " << e.what()
+                      << std::endl;
+            *status = -1;
+        }
+    }
+}
+
+template <class AnalysisClass>
+int processChainInParallel(TChain* chain,
+                           const std::vector<std::string>& infiles,
+                           const std::string& outfile,
+                           const std::set<std::string>& histoRequest,
+                           const unsigned long maxEvents, const bool verbose,
+                           const typename AnalysisClass::options_type& opts,
+                           const unsigned nThreads,
+                           const Long64_t firstEntry, const Long64_t lastEntry,
+                           Long64_t* eventCounter, Long64_t* processCounter,
+                           const std::function<void(AnalysisClass&)>&
+                           configure = std::function<void(AnalysisClass&)>(),
+                           StageTiming* timing = 0,
+                           const bool shareHistograms = false,
+                           MemoryProfile* memory = 0)
+{
+    assert(chain);
+    assert(nThreads);
+    assert(firstEntry >= 0);
+
+    ROOT::EnableThreadSafety();
+
+    const Long64_t chainEntries = chain->GetEntries();
+    const Long64_t rangeEnd = lastEntry >= 0 && lastEntry < chainEntries ?
+                              lastEntry : chainEntries;
+    const Long64_t rangeStart = firstEntry < rangeEnd ? firstEntry : rangeEnd;
+    const Long64_t nentries = rangeEnd - rangeStart;
+    std::atomic<Long64_t> sharedCounter(0);
+
+    // Must outlive the analysis objects
+    SharedHistoStore sharedStore;
+
+    // Analysis objects and chains are built serially because some
+    // of the things they create (e.g., FFTW plans) are not thread-safe
+    std::vector<TChain*> chains(nThreads, 0);
+    std::vector<AnalysisClass*> workers(nThreads, 0);
+    chains[0] = chain;
+    for (unsigned iw=0; iw<nThreads; ++iw)
+    {
+        if (iw)
+        {
+            chains[iw] = new TChain(chain->GetName());
+            const unsigned nFiles = infiles.size();
+            for (unsigned i=0; i<nFiles; ++i)
+                chains[iw]->Add(infiles[i].c_str());
+        }
+        const std::string& fname = iw ? Private::workerOutputFile(outfile, iw)
+                                      : outfile;
+        workers[iw] = new AnalysisClass(chains[iw], fname, histoRequest,
+                                        maxEvents, verbose && iw == 0, opts);
+        const Long64_t first = rangeStart + (nentries*iw)/nThreads;
+        const Long64_t last = rangeStart + (nentries*(iw + 1U))/nThreads;
+        workers[iw]->setEntryRange(first, last);
+        workers[iw]->setSharedProcessCounter(&sharedCounter);
+        workers[iw]->setWorkerNumber(iw);
+        if (shareHistograms)
+            workers[iw]->setSharedHistoStore(&sharedStore);
+        if (configure)
+            configure(*workers[iw]);
+    }
+
+    // Run the event loops. The "endJob" method of the first
+    // worker will be called after merging the results.
+    std::vector<int> statuses(nThreads, 0);
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads);
+    for (unsigned iw=0; iw<nThreads; ++iw)
+        threads.push_back(std::thread(
+            Private::runWorkerEventLoop<AnalysisClass>,
+            workers[iw], iw > 0U, &statuses[iw]));
+    for (unsigned iw=0; iw<nThreads; ++iw)
+        threads[iw].join();
+
+    int status = 0;
+    for (unsigned iw=0; iw<nThreads && !status; ++iw)
+        status = statuses[iw];
+
+    if (shareHistograms && !status)
+    {
+        try {
+            sharedStore.materialize();
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error in processChainInParallel: " << e.what()
+                      << std::endl;
+            status = -1;
+        }
+    }
+
+    // Merge the results in the order of entry ranges
+    for (unsigned iw=1; iw<nThreads && !status; ++iw)
+        status = workers[0]->mergeResults(*workers[iw]);
+
+    const int endStatus = workers[0]->finish();
+    if (!status)
+        status = endStatus;
+
+    *eventCounter = 0;
+    *processCounter = 0;
+    for (unsigned iw=0; iw<nThreads; ++iw)
+    {
+        *eventCounter += workers[iw]->getEventCounter();
+        *processCounter += workers[iw]->getProcessCounter();
+    }
+    if (timing)
+    {
+        *timing = workers[0]->getTiming();
+        for (unsigned iw=1; iw<nThreads; ++iw)
+            timing->merge(workers[iw]->getTiming());
+    }
+    if (memory)
+    {
+        *memory = workers[0]->getMemoryProfile();
+        for (unsigned iw=1; iw<nThreads; ++iw)
+            memory->merge(workers[iw]->getMemoryProfile());
+    }
+
+    // Clean up. The temporary output files are complete only
+    // after the corresponding analysis objects are destroyed.
+    for (unsigned iw=1; iw<nThreads; ++iw)
+    {
+        delete workers[iw];
+        delete chains[iw];
+        std::remove(Private::workerOutputFile(outfile, iw).c_str());
+    }
+    delete workers[0];
+
+    return status;
+}
+
+#endif // processChainInParallel_h_
@@ -0,0 +1,26 @@
+#ifndef zeroWeightFills_h_
+#define zeroWeightFills_h_
+
+//
+// Bookkeeping for histogram fills with zero weight which were skipped.
+//
+// For root, a fill with zero weight is not a NOOP: it increments
+// the number of entries and, unless already done, switches on the
+// storage of the sums of squared weights. Cycled histograms which
+// skip such fills call this function to keep the histogram state
+// identical to what it would be if every fill had been performed.
+//
+
+#include "TH1.h"
+
+inline void recordZeroWeightFills(TH1* histo, const unsigned nSkipped)
+{
+    if (nSkipped)
+    {
+        if (!histo->GetSumw2N())
+            histo->Sumw2();
+        histo->SetEntries(histo->GetEntries() + nSkipped);
+    }
+}
+
+#endif // zeroWeightFills_h_